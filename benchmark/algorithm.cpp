@@ -0,0 +1,163 @@
+#include "../include/algorithm.h"
+#include "../include/tag_map_vector.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"region", std::uint16_t>,
+    ctmap::tagged_value<"timestamp", std::int32_t>,
+    ctmap::tagged_value<"host", std::string>,
+    ctmap::tagged_value<"path", std::string>,
+    ctmap::tagged_value<"latency", double>,
+    ctmap::tagged_value<"payload", std::array<char, 256>>
+>;
+
+std::vector<record> make_records(size_t count)
+{
+    std::vector<record> records;
+    records.reserve(count);
+    std::minstd_rand random(42);
+    for (auto index = 0uz; index < count; ++index)
+        records.emplace_back(std::uint16_t(random() % 32), std::int32_t(random() % 1000000) - 500000,
+                             "host-" + std::to_string(random() % 512), std::string("/api/v1/resource/with/a/long/path"),
+                             double(random() % 1000) / 8.0, std::array<char, 256>{ char(index) });
+    return records;
+}
+
+void sort_by_radix(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        ctmap::sort_by<"region", "timestamp">(copy);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void sort_by_comparison(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        ctmap::sort_by<"host", "latency">(copy);
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void sort_by_column_store(benchmark::State& state)
+{
+    ctmap::tag_map_vector_from_tag_map_t<record> records;
+    for (auto const& row : make_records(size_t(state.range(0))))
+        records.push_back(row);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        ctmap::sort_by<"region", "timestamp">(copy);
+        benchmark::DoNotOptimize(copy.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void std_stable_sort_records(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        std::ranges::stable_sort(copy, [](record const& lhs, record const& rhs)
+                                 {
+                                     return std::tie(lhs.get<"region">(), lhs.get<"timestamp">()) < std::tie(rhs.get<"region">(), rhs.get<"timestamp">());
+                                 });
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void std_stable_sort_records_string_key(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        std::ranges::stable_sort(copy, [](record const& lhs, record const& rhs)
+                                 {
+                                     return std::tie(lhs.get<"host">(), lhs.get<"latency">()) < std::tie(rhs.get<"host">(), rhs.get<"latency">());
+                                 });
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void group_by_region(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(ctmap::group_by<"region">(copy).size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void partition_by_latency(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(ctmap::partition_by<"latency">(copy, [](double latency) { return latency < 50.0; }));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void std_stable_partition_records(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = records;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(std::ranges::stable_partition(copy, [](record const& row) { return row.get<"latency">() < 50.0; }).begin());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(sort_by_radix)->Range(1 << 10, 1 << 16);
+BENCHMARK(std_stable_sort_records)->Range(1 << 10, 1 << 16);
+BENCHMARK(sort_by_column_store)->Range(1 << 10, 1 << 16);
+BENCHMARK(sort_by_comparison)->Range(1 << 10, 1 << 16);
+BENCHMARK(std_stable_sort_records_string_key)->Range(1 << 10, 1 << 16);
+BENCHMARK(group_by_region)->Range(1 << 10, 1 << 16);
+BENCHMARK(partition_by_latency)->Range(1 << 10, 1 << 16);
+BENCHMARK(std_stable_partition_records)->Range(1 << 10, 1 << 16);
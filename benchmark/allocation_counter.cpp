@@ -0,0 +1,75 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+
+void* operator new(std::size_t size)
+{
+    if (ctmap::benchmark::countingAllocations)
+        ++ctmap::benchmark::allocationCount;
+    if (auto* pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+// std::pmr::new_delete_resource allocates through the aligned forms
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (ctmap::benchmark::countingAllocations)
+        ++ctmap::benchmark::allocationCount;
+    auto const align = static_cast<std::size_t>(alignment);
+    if (auto* pointer = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+
+
+namespace ctmap::benchmark
+{
+/**
+* Global operator new calls of the current thread while it counts, by the replacements in allocation_counter.cpp.
+* Thread local, so benchmarks that do not count allocations, multi threaded ones in particular, only pay for a check
+* of countingAllocations and never share a cache line for it.
+*/
+inline thread_local std::size_t allocationCount = 0;
+inline thread_local bool countingAllocations = false;
+
+/**
+* Counts the allocations of the current thread from construction to destruction.
+*/
+class allocation_scope
+{
+public:
+
+    allocation_scope() noexcept
+        : countBefore(allocationCount)
+    {
+        countingAllocations = true;
+    }
+
+    allocation_scope(allocation_scope const&) = delete;
+    allocation_scope& operator=(allocation_scope const&) = delete;
+
+    ~allocation_scope()
+    {
+        countingAllocations = false;
+    }
+
+    std::size_t allocations() const noexcept
+    {
+        return allocationCount - countBefore;
+    }
+
+private:
+
+    std::size_t countBefore;
+};
+}
@@ -0,0 +1,172 @@
+#include "../include/arithmetic.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+using metrics = ctmap::tag_map<
+    ctmap::tagged_value<"requests", double>,
+    ctmap::tagged_value<"errors", double>,
+    ctmap::tagged_value<"retries", double>,
+    ctmap::tagged_value<"timeouts", double>,
+    ctmap::tagged_value<"bytes_in", double>,
+    ctmap::tagged_value<"bytes_out", double>,
+    ctmap::tagged_value<"latency_sum", double>,
+    ctmap::tagged_value<"latency_max", double>,
+    ctmap::tagged_value<"queue_sum", double>,
+    ctmap::tagged_value<"queue_max", double>,
+    ctmap::tagged_value<"cpu_seconds", double>,
+    ctmap::tagged_value<"memory_peak", double>
+>;
+
+// a shard reporting a subset of the metrics, in its own order
+using shard_metrics = ctmap::tag_map<
+    ctmap::tagged_value<"latency_max", double>,
+    ctmap::tagged_value<"errors", double>,
+    ctmap::tagged_value<"requests", double>,
+    ctmap::tagged_value<"bytes_out", double>
+>;
+
+metrics make_metrics(size_t index)
+{
+    auto const value = double(index % 97);
+    return metrics(value, value * 0.01, value * 0.02, value * 0.005, value * 512, value * 2048, value * 3.5, value * 0.7,
+                   value * 1.5, value * 0.3, value * 0.02, value * 4096);
+}
+
+std::vector<metrics> make_metrics_vector(size_t count)
+{
+    std::vector<metrics> records;
+    records.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+        records.push_back(make_metrics(index));
+    return records;
+}
+
+std::vector<shard_metrics> make_shard_metrics_vector(size_t count)
+{
+    std::vector<shard_metrics> records;
+    records.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+    {
+        auto const value = double(index % 89);
+        records.emplace_back(value * 0.9, value * 0.02, value, value * 1024);
+    }
+    return records;
+}
+
+// the element-wise helpers every step of which returns a full temporary tag map
+template<typename _Function>
+metrics combine_naive(metrics const& lhs,
+                      metrics const& rhs,
+                      _Function&& function)
+{
+    metrics result;
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        ((result.get<_Indices>().value = function(lhs.get<_Indices>().value, rhs.get<_Indices>().value)), ...);
+    }(std::make_index_sequence<std::tuple_size_v<metrics>>());
+    return result;
+}
+
+metrics add_naive(metrics const& lhs,
+                  metrics const& rhs)
+{
+    return combine_naive(lhs, rhs, [](double lhsValue, double rhsValue) { return lhsValue + rhsValue; });
+}
+
+metrics max_naive(metrics const& lhs,
+                  metrics const& rhs)
+{
+    return combine_naive(lhs, rhs, [](double lhsValue, double rhsValue) { return lhsValue < rhsValue ? rhsValue : lhsValue; });
+}
+
+metrics scale_naive(metrics const& tagMap,
+                    double factor)
+{
+    return combine_naive(tagMap, tagMap, [&](double value, double) { return value * factor; });
+}
+
+metrics widen_naive(shard_metrics const& shard)
+{
+    metrics result;
+    result.get<"latency_max">() = shard.get<"latency_max">();
+    result.get<"errors">() = shard.get<"errors">();
+    result.get<"requests">() = shard.get<"requests">();
+    result.get<"bytes_out">() = shard.get<"bytes_out">();
+    return result;
+}
+
+// totals = (totals + current * weight) * decay, the peaks as the maximum of both
+void aggregate_temporaries(benchmark::State& state)
+{
+    auto const records = make_metrics_vector(state.range(0));
+    for (auto _ : state)
+    {
+        metrics totals;
+        metrics peaks;
+        for (auto const& current : records)
+        {
+            totals = scale_naive(add_naive(totals, scale_naive(current, 0.25)), 0.999);
+            peaks = max_naive(peaks, current);
+        }
+        benchmark::DoNotOptimize(totals);
+        benchmark::DoNotOptimize(peaks);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void aggregate_expression(benchmark::State& state)
+{
+    auto const records = make_metrics_vector(state.range(0));
+    for (auto _ : state)
+    {
+        metrics totals;
+        metrics peaks;
+        for (auto const& current : records)
+        {
+            totals = (totals + current * 0.25) * 0.999;
+            peaks = ctmap::max(peaks, current);
+        }
+        benchmark::DoNotOptimize(totals);
+        benchmark::DoNotOptimize(peaks);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void merge_shards_temporaries(benchmark::State& state)
+{
+    auto const shards = make_shard_metrics_vector(state.range(0));
+    for (auto _ : state)
+    {
+        metrics totals;
+        for (auto const& shard : shards)
+            totals = add_naive(totals, widen_naive(shard));
+        benchmark::DoNotOptimize(totals);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void merge_shards_expression(benchmark::State& state)
+{
+    auto const shards = make_shard_metrics_vector(state.range(0));
+    for (auto _ : state)
+    {
+        metrics totals;
+        for (auto const& shard : shards)
+            totals += shard;
+        benchmark::DoNotOptimize(totals);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(aggregate_temporaries)->Arg(1 << 12);
+BENCHMARK(aggregate_expression)->Arg(1 << 12);
+BENCHMARK(merge_shards_temporaries)->Arg(1 << 12);
+BENCHMARK(merge_shards_expression)->Arg(1 << 12);
@@ -0,0 +1,120 @@
+#include "../include/column_file.h"
+#include "../include/serialization.h"
+#include "../include/simd.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"active", bool>
+>;
+
+constexpr size_t row_count = 1 << 22;
+
+record make_record(size_t index)
+{
+    return record(std::uint64_t(index), double(index % 1000) * 0.25, std::int32_t(index % 17), index % 3 == 0);
+}
+
+std::filesystem::path const& column_file_path()
+{
+    static auto const path = []
+    {
+        auto path = std::filesystem::temp_directory_path() / "ctmap_benchmark.ctmapcol";
+        std::filesystem::remove(path);
+        ctmap::tag_map_vector_from_tag_map_t<record> tagMaps;
+        tagMaps.reserve(row_count);
+        for (auto index = 0uz; index < row_count; ++index)
+            tagMaps.push_back(make_record(index));
+        ctmap::column_file_writer<record>(path).append(tagMaps);
+        return path;
+    }();
+    return path;
+}
+
+std::filesystem::path const& serialized_path()
+{
+    static auto const path = []
+    {
+        auto path = std::filesystem::temp_directory_path() / "ctmap_benchmark.bin";
+        std::vector<record> tagMaps;
+        tagMaps.reserve(row_count);
+        for (auto index = 0uz; index < row_count; ++index)
+            tagMaps.push_back(make_record(index));
+        auto const bytes = ctmap::serialize(std::span<record const>(tagMaps));
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<char const*>(bytes.data()), std::streamsize(bytes.size()));
+        return path;
+    }();
+    return path;
+}
+
+void startup_rebuild(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        ctmap::tag_map_vector_from_tag_map_t<record> tagMaps;
+        tagMaps.reserve(row_count);
+        for (auto index = 0uz; index < row_count; ++index)
+            tagMaps.push_back(make_record(index));
+        benchmark::DoNotOptimize(ctmap::column_sum<"price">(tagMaps));
+    }
+    state.SetItemsProcessed(state.iterations() * row_count);
+}
+
+void startup_deserialize(benchmark::State& state)
+{
+    auto const& path = serialized_path();
+    for (auto _ : state)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<std::byte> bytes(std::filesystem::file_size(path));
+        in.read(reinterpret_cast<char*>(bytes.data()), std::streamsize(bytes.size()));
+        auto const tagMaps = ctmap::deserialize_batch<record>(bytes);
+        double sum = 0.;
+        for (auto const& tagMap : tagMaps)
+            sum += tagMap.get<"price">();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * row_count);
+}
+
+void startup_column_file(benchmark::State& state)
+{
+    auto const& path = column_file_path();
+    for (auto _ : state)
+    {
+        ctmap::column_file<record> const file(path);
+        double sum = 0.;
+        for (auto const& batch : file)
+            sum += ctmap::column_sum<"price">(batch);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * row_count);
+}
+
+void open_column_file(benchmark::State& state)
+{
+    auto const& path = column_file_path();
+    for (auto _ : state)
+    {
+        ctmap::column_file<record> const file(path);
+        benchmark::DoNotOptimize(file.batch(0).column<"price">().data());
+    }
+}
+}
+
+BENCHMARK(startup_rebuild)->Unit(benchmark::kMillisecond);
+BENCHMARK(startup_deserialize)->Unit(benchmark::kMillisecond);
+BENCHMARK(startup_column_file)->Unit(benchmark::kMillisecond);
+BENCHMARK(open_column_file)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""
+Compile time benchmark for tag maps with many tags.
+
+Generates one translation unit per tag count, each declaring a tag map with that many tags
+and accessing every tag by name, compiles it and records wall time, peak compiler memory
+and the number of template instantiations emitted into the object file.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+INCLUDE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), os.pardir, "include")
+
+
+def generate_source(tag_count):
+    tags = [f"tag{index}" for index in range(tag_count)]
+    lines = ['#include "ctmap.h"', ""]
+    lines.append("using benchmark_tag_map = ctmap::tag_map<")
+    lines.append(",\n".join(f'    ctmap::tagged_value<"{tag}", int>' for tag in tags))
+    lines.append(">;")
+    lines.append("")
+    lines.append("int sum(benchmark_tag_map const& tagMap)")
+    lines.append("{")
+    lines.append("    return 0")
+    lines.extend(f'        + tagMap.get<"{tag}">()' for tag in tags)
+    lines.append("        ;")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+def compile_source(compiler, flags, source_path, object_path):
+    command = [compiler, *flags, "-I", INCLUDE_DIR, "-c", source_path, "-o", object_path]
+    start = time.perf_counter()
+    process = subprocess.Popen(command, stderr=subprocess.PIPE, text=True)
+    _, status, usage = os.wait4(process.pid, 0)
+    seconds = time.perf_counter() - start
+    errors = process.stderr.read()
+    process.stderr.close()
+    if os.waitstatus_to_exitcode(status) != 0:
+        raise RuntimeError(f"compilation failed:\n{errors}")
+    # ru_maxrss is reported in kilobytes on Linux
+    return seconds, usage.ru_maxrss * 1024
+
+
+def count_instantiations(object_path):
+    """Weak definitions in the object file, which is where inline functions and function template instantiations end up."""
+    nm = shutil.which("nm")
+    if nm is None:
+        return None
+    symbols = subprocess.run([nm, "--defined-only", object_path], check=True, capture_output=True, text=True).stdout
+    return sum(1 for line in symbols.splitlines() if line.split()[-2:-1] in (["W"], ["V"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--compiler", default=os.environ.get("CXX", "c++"))
+    parser.add_argument("--flags", default="-std=c++2b -O0",
+                        help="compiler flags, separated by spaces")
+    parser.add_argument("--sizes", default="100,500,1000",
+                        help="comma separated tag counts")
+    parser.add_argument("--output", help="write the results as JSON to this file")
+    arguments = parser.parse_args()
+
+    results = []
+    with tempfile.TemporaryDirectory() as directory:
+        for tag_count in (int(size) for size in arguments.sizes.split(",")):
+            source_path = os.path.join(directory, f"tag_map_{tag_count}.cpp")
+            with open(source_path, "w") as source:
+                source.write(generate_source(tag_count))
+            object_path = os.path.join(directory, f"tag_map_{tag_count}.o")
+            seconds, peak_memory = compile_source(arguments.compiler,
+                                                  arguments.flags.split(),
+                                                  source_path,
+                                                  object_path)
+            instantiations = count_instantiations(object_path)
+            results.append({
+                "tags": tag_count,
+                "seconds": round(seconds, 3),
+                "peak_memory_bytes": peak_memory,
+                "instantiations": instantiations,
+            })
+            print(f"{tag_count:>6} tags: {seconds:8.2f} s, {peak_memory / 2**20:8.1f} MiB, {instantiations} instantiations", file=sys.stderr)
+
+    report = {
+        "compiler": arguments.compiler,
+        "flags": arguments.flags,
+        "results": results,
+    }
+    if arguments.output:
+        with open(arguments.output, "w") as output:
+            json.dump(report, output, indent=4)
+    else:
+        json.dump(report, sys.stdout, indent=4)
+        print()
+
+
+if __name__ == "__main__":
+    main()
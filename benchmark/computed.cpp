@@ -0,0 +1,128 @@
+#include "../include/ctmap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cctype>
+#include <cstdint>
+#include <string>
+
+
+namespace
+{
+struct normalize_key
+{
+    std::string operator()(std::string const& domain,
+                           std::string const& name,
+                           int id) const
+    {
+        std::string key;
+        key.reserve(domain.size() + name.size() + 12);
+        for (auto character : domain)
+            key += char(std::tolower(static_cast<unsigned char>(character)));
+        key += '/';
+        for (auto character : name)
+            key += char(std::tolower(static_cast<unsigned char>(character)));
+        key += '#';
+        key += std::to_string(id);
+        return key;
+    }
+};
+
+struct checksum_key
+{
+    std::uint64_t operator()(std::string const& key) const noexcept
+    {
+        auto hash = std::uint64_t(14695981039346656037ull);
+        for (auto character : key)
+            hash = (hash ^ static_cast<unsigned char>(character)) * 1099511628211ull;
+        return hash;
+    }
+};
+
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"domain", std::string>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"id", int>,
+    ctmap::tagged_value<"hits", int>
+>;
+
+using computed_record = ctmap::tag_map<
+    ctmap::tagged_value<"domain", std::string>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"id", int>,
+    ctmap::tagged_value<"hits", int>,
+    ctmap::computed_tag<"key", normalize_key, "domain", "name", "id">,
+    ctmap::computed_tag<"checksum", checksum_key, "key">
+>;
+
+record make_record()
+{
+    return record(std::string("Customers.Example.COM"), std::string("Order-Archive-Service"), 4711, 0);
+}
+
+computed_record make_computed_record()
+{
+    return computed_record(std::string("Customers.Example.COM"), std::string("Order-Archive-Service"), 4711, 0, ctmap::computed, ctmap::computed);
+}
+
+void checksum_read_eager(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    for (auto _ : state)
+    {
+        auto const checksum = tagMap.apply<"domain", "name", "id">([](auto const&... values)
+                                                                  {
+                                                                      return checksum_key()(normalize_key()(values...));
+                                                                  });
+        benchmark::DoNotOptimize(checksum);
+    }
+}
+
+void checksum_read_computed(benchmark::State& state)
+{
+    auto const tagMap = make_computed_record();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(tagMap.get<"checksum">());
+}
+
+// writes to a tag no computed value depends on keep the cache
+void checksum_read_after_unrelated_write_computed(benchmark::State& state)
+{
+    auto tagMap = make_computed_record();
+    for (auto _ : state)
+    {
+        ++tagMap.get<"hits">();
+        benchmark::DoNotOptimize(tagMap.get<"checksum">());
+    }
+}
+
+void checksum_read_after_dependency_write_eager(benchmark::State& state)
+{
+    auto tagMap = make_record();
+    for (auto _ : state)
+    {
+        ++tagMap.get<"id">();
+        auto const checksum = tagMap.apply<"domain", "name", "id">([](auto const&... values)
+                                                                  {
+                                                                      return checksum_key()(normalize_key()(values...));
+                                                                  });
+        benchmark::DoNotOptimize(checksum);
+    }
+}
+
+void checksum_read_after_dependency_write_computed(benchmark::State& state)
+{
+    auto tagMap = make_computed_record();
+    for (auto _ : state)
+    {
+        ++tagMap.get<"id">();
+        benchmark::DoNotOptimize(tagMap.get<"checksum">());
+    }
+}
+}
+
+BENCHMARK(checksum_read_eager);
+BENCHMARK(checksum_read_computed);
+BENCHMARK(checksum_read_after_unrelated_write_computed);
+BENCHMARK(checksum_read_after_dependency_write_eager);
+BENCHMARK(checksum_read_after_dependency_write_computed);
@@ -0,0 +1,135 @@
+#include "../include/concurrent_tag_map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+
+namespace
+{
+using config_tagged_values = std::tuple<
+    ctmap::tagged_value<"version", std::uint64_t>,
+    ctmap::tagged_value<"maxConnections", int>,
+    ctmap::tagged_value<"timeout", double>,
+    ctmap::tagged_value<"enabled", bool>,
+    ctmap::tagged_value<"endpoint", std::string>
+>;
+
+template<template<typename...> typename _Map, typename _Tuple>
+struct apply_tagged_values;
+
+template<template<typename...> typename _Map, typename... _TaggedValues>
+struct apply_tagged_values<_Map, std::tuple<_TaggedValues...>>
+{
+    using type = _Map<_TaggedValues...>;
+};
+
+using config = apply_tagged_values<ctmap::tag_map, config_tagged_values>::type;
+using concurrent_config = apply_tagged_values<ctmap::concurrent_tag_map, config_tagged_values>::type;
+
+struct shared_mutex_config
+{
+    std::shared_mutex mutex;
+    config values = config(1ull, 64, 0.5, true, std::string("https://localhost:8443/api"));
+};
+
+concurrent_config& shared_concurrent_config()
+{
+    static concurrent_config instance(1ull, 64, 0.5, true, std::string("https://localhost:8443/api"));
+    return instance;
+}
+
+shared_mutex_config& shared_locked_config()
+{
+    static shared_mutex_config instance;
+    return instance;
+}
+
+// thread 0 writes one tag and then two tags together, all other threads read
+void concurrent_tag_map_snapshot(benchmark::State& state)
+{
+    auto& shared = shared_concurrent_config();
+    auto counter = 0;
+    for (auto _ : state)
+        if (state.thread_index() == 0)
+        {
+            shared.store<"maxConnections">(++counter);
+            shared.update<"version", "timeout">([](std::uint64_t& version, double& timeout)
+                                                {
+                                                    ++version;
+                                                    timeout += 0.125;
+                                                });
+        }
+        else
+        {
+            auto const limits = shared.snapshot<"maxConnections", "timeout", "enabled">();
+            benchmark::DoNotOptimize(limits);
+            benchmark::DoNotOptimize(shared.load<"version">());
+        }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void shared_mutex_tag_map(benchmark::State& state)
+{
+    auto& shared = shared_locked_config();
+    auto counter = 0;
+    for (auto _ : state)
+        if (state.thread_index() == 0)
+        {
+            {
+                std::unique_lock lock(shared.mutex);
+                shared.values.get<"maxConnections">() = ++counter;
+            }
+            std::unique_lock lock(shared.mutex);
+            ++shared.values.get<"version">();
+            shared.values.get<"timeout">() += 0.125;
+        }
+        else
+        {
+            std::shared_lock lock(shared.mutex);
+            auto const limits = ctmap::make_tag_map<"maxConnections", "timeout", "enabled">(shared.values.get<"maxConnections">(),
+                                                                                            shared.values.get<"timeout">(),
+                                                                                            shared.values.get<"enabled">());
+            benchmark::DoNotOptimize(limits);
+            benchmark::DoNotOptimize(shared.values.get<"version">());
+        }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void concurrent_tag_map_snapshot_string(benchmark::State& state)
+{
+    auto& shared = shared_concurrent_config();
+    for (auto _ : state)
+        if (state.thread_index() == 0)
+            shared.store<"endpoint">(std::string("https://localhost:8443/api"));
+        else
+            benchmark::DoNotOptimize(shared.snapshot<"endpoint", "version">());
+    state.SetItemsProcessed(state.iterations());
+}
+
+void shared_mutex_tag_map_string(benchmark::State& state)
+{
+    auto& shared = shared_locked_config();
+    for (auto _ : state)
+        if (state.thread_index() == 0)
+        {
+            std::string endpoint("https://localhost:8443/api");
+            std::unique_lock lock(shared.mutex);
+            shared.values.get<"endpoint">() = std::move(endpoint);
+        }
+        else
+        {
+            std::shared_lock lock(shared.mutex);
+            benchmark::DoNotOptimize(ctmap::make_tag_map<"endpoint", "version">(shared.values.get<"endpoint">(), shared.values.get<"version">()));
+        }
+    state.SetItemsProcessed(state.iterations());
+}
+}
+
+BENCHMARK(concurrent_tag_map_snapshot)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(shared_mutex_tag_map)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(concurrent_tag_map_snapshot_string)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(shared_mutex_tag_map_string)->ThreadRange(2, 8)->UseRealTime();
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+
+
+namespace ctmap::benchmark
+{
+/**
+* Copies and moves of all copy_move_counted values since the last reset.
+*/
+struct copy_move_counts
+{
+    std::size_t copies = 0;
+    std::size_t moves = 0;
+
+    bool operator==(copy_move_counts const&) const = default;
+};
+
+inline copy_move_counts copyMoveCounts;
+
+/**
+* Value type counting its copy and move constructions and assignments in copyMoveCounts.
+*/
+class copy_move_counted
+{
+public:
+
+    copy_move_counted() = default;
+
+    explicit copy_move_counted(int value) noexcept
+        : value(value)
+    {}
+
+    copy_move_counted(copy_move_counted const& other) noexcept
+        : value(other.value)
+    {
+        ++copyMoveCounts.copies;
+    }
+
+    copy_move_counted(copy_move_counted&& other) noexcept
+        : value(other.value)
+    {
+        ++copyMoveCounts.moves;
+    }
+
+    copy_move_counted& operator=(copy_move_counted const& other) noexcept
+    {
+        value = other.value;
+        ++copyMoveCounts.copies;
+        return *this;
+    }
+
+    copy_move_counted& operator=(copy_move_counted&& other) noexcept
+    {
+        value = other.value;
+        ++copyMoveCounts.moves;
+        return *this;
+    }
+
+    bool operator==(copy_move_counted const&) const = default;
+
+    int value = 0;
+};
+
+inline copy_move_counts reset_copy_move_counts() noexcept
+{
+    auto const counts = copyMoveCounts;
+    copyMoveCounts = copy_move_counts();
+    return counts;
+}
+}
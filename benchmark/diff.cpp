@@ -0,0 +1,109 @@
+#include "../include/diff.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+namespace
+{
+constexpr size_t field_count = 50;
+
+template<size_t _Index>
+constexpr ctmap::char_tag<4> field_tag = []
+{
+    char const name[4] = { 'f', char('0' + _Index / 10), char('0' + _Index % 10), '\0' };
+    return ctmap::char_tag<4>(name);
+}();
+
+template<size_t _Index>
+using field_type_t = std::conditional_t<_Index % 8 == 7, std::string, std::conditional_t<_Index % 2 == 0, std::int64_t, double>>;
+
+template<size_t... _Indices>
+auto make_record_type(std::index_sequence<_Indices...>) -> ctmap::tag_map<ctmap::tagged_value<field_tag<_Indices>, field_type_t<_Indices>>...>;
+
+using record = decltype(make_record_type(std::make_index_sequence<field_count>()));
+
+template<size_t _Index>
+field_type_t<_Index> field_value()
+{
+    if constexpr (std::is_same_v<field_type_t<_Index>, std::string>)
+        return std::string(24, char('a' + _Index % 26));
+    else
+        return field_type_t<_Index>(_Index);
+}
+
+record make_record()
+{
+    return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        return record(field_value<_Indices>()...);
+    }(std::make_index_sequence<field_count>());
+}
+
+/**
+* Two states of a record differing in two values, one in the middle and one at the end.
+*/
+std::pair<record, record> const& states()
+{
+    static std::pair<record, record> const result = []
+    {
+        std::pair<record, record> states(make_record(), make_record());
+        states.second.get<"f24">() += 1;
+        states.second.get<"f47">() = "changed";
+        return states;
+    }();
+    return result;
+}
+
+void sync_compare_and_copy(benchmark::State& state)
+{
+    auto const& [first, second] = states();
+    auto target = first;
+    for (auto _ : state)
+    {
+        if (target != second)
+            target = second;
+        if (target != first)
+            target = first;
+        benchmark::DoNotOptimize(target);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+void sync_diff_and_patch(benchmark::State& state)
+{
+    auto const& [first, second] = states();
+    auto target = first;
+    for (auto _ : state)
+    {
+        ctmap::patch(target, ctmap::diff(target, second));
+        ctmap::patch(target, ctmap::diff(target, first));
+        benchmark::DoNotOptimize(target);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+    state.counters["changed_tags"] = double(ctmap::diff(first, second).count());
+}
+
+void equal_operator(benchmark::State& state)
+{
+    auto const& [first, second] = states();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(first == second);
+}
+
+void equal_differs(benchmark::State& state)
+{
+    auto const& [first, second] = states();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::differs(first, second));
+}
+}
+
+BENCHMARK(sync_compare_and_copy);
+BENCHMARK(sync_diff_and_patch);
+BENCHMARK(equal_operator);
+BENCHMARK(equal_differs);
@@ -0,0 +1,85 @@
+#include <version>
+#if defined(__cpp_lib_format)
+#include "../include/formatter.h"
+#include "allocation_counter.h"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <format>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+
+namespace
+{
+auto make_log_line()
+{
+    return ctmap::make_tag_map<"timestamp", "level", "latency", "status", "path", "cached">(
+        1700000000123ll,
+        std::string("info"),
+        0.125,
+        200u,
+        std::string("/api/v1/records"),
+        true
+    );
+}
+
+template<typename _Function>
+void run_and_count_allocations(benchmark::State& state,
+                               _Function&& function)
+{
+    ctmap::benchmark::allocation_scope scope;
+    for (auto _ : state)
+        function();
+    state.counters["allocations_per_iteration"] = benchmark::Counter(double(scope.allocations()) / double(state.iterations()));
+}
+
+void format_to_buffer(benchmark::State& state)
+{
+    auto const tagMap = make_log_line();
+    std::array<char, 512> buffer;
+    run_and_count_allocations(state, [&]
+                              {
+                                  auto const end = std::format_to(buffer.data(), "{}", tagMap);
+                                  benchmark::DoNotOptimize(end);
+                              });
+}
+
+void format_to_buffer_with_value_specs(benchmark::State& state)
+{
+    auto const tagMap = make_log_line();
+    std::array<char, 512> buffer;
+    run_and_count_allocations(state, [&]
+                              {
+                                  auto const end = std::format_to(buffer.data(), "{:|latency:.3f|status:>5}", tagMap);
+                                  benchmark::DoNotOptimize(end);
+                              });
+}
+
+void stringstream_and_quoted(benchmark::State& state)
+{
+    auto const tagMap = make_log_line();
+    run_and_count_allocations(state, [&]
+                              {
+                                  std::ostringstream out;
+                                  out << "{ ";
+                                  bool skipDelim = true;
+                                  ctmap::apply([&](auto const&... taggedValues)
+                                               {
+                                                   ((out << (std::exchange(skipDelim, false) ? "" : ", ")
+                                                         << std::quoted(taggedValues.tag.value) << ": "
+                                                         << std::quoted((std::stringstream() << taggedValues.value).str())), ...);
+                                               },
+                                               tagMap);
+                                  out << " }";
+                                  benchmark::DoNotOptimize(std::move(out).str());
+                              });
+}
+}
+
+BENCHMARK(format_to_buffer);
+BENCHMARK(format_to_buffer_with_value_specs);
+BENCHMARK(stringstream_and_quoted);
+#endif
@@ -0,0 +1,148 @@
+#include "../include/ctmap.h"
+#include "copy_move_counter.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <utility>
+
+
+namespace
+{
+using ctmap::benchmark::copy_move_counted;
+using ctmap::benchmark::copy_move_counts;
+
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", copy_move_counted>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"quantity", copy_move_counted>
+>;
+
+using annotation = ctmap::tag_map<
+    ctmap::tagged_value<"origin", copy_move_counted>
+>;
+
+using packed_record = ctmap::packed_tag_map<
+    ctmap::tagged_value<"id", copy_move_counted>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"quantity", copy_move_counted>
+>;
+
+record make_record()
+{
+    return record(copy_move_counted(1), std::string("a name too long for the small string buffer"), copy_move_counted(2));
+}
+
+/**
+* Runs function, which returns the copies and moves of copy_move_counted values it made on top of preparing its arguments,
+* and fails the benchmark if they exceed the minimum the operation needs.
+*/
+template<typename _Function>
+void run_and_check_copies(benchmark::State& state,
+                          copy_move_counts minimum,
+                          _Function&& function)
+{
+    copy_move_counts counts;
+    for (auto _ : state)
+        counts = function();
+    state.counters["copies"] = double(counts.copies);
+    state.counters["moves"] = double(counts.moves);
+    if (counts.copies > minimum.copies || counts.moves > minimum.moves)
+        state.SkipWithError("more copies or moves than needed");
+}
+
+template<typename _Function>
+copy_move_counts count_copies(_Function&& function)
+{
+    ctmap::benchmark::reset_copy_move_counts();
+    function();
+    return ctmap::benchmark::reset_copy_move_counts();
+}
+
+void tag_map_cat_lvalues(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    annotation const extra(copy_move_counted(3));
+    run_and_check_copies(state, { .copies = 3, .moves = 0 }, [&]
+                         {
+                             return count_copies([&] { benchmark::DoNotOptimize(ctmap::tag_map_cat(tagMap, extra)); });
+                         });
+}
+
+void tag_map_cat_rvalues(benchmark::State& state)
+{
+    run_and_check_copies(state, { .copies = 0, .moves = 3 }, [&]
+                         {
+                             auto tagMap = make_record();
+                             annotation extra(copy_move_counted(3));
+                             return count_copies([&] { benchmark::DoNotOptimize(ctmap::tag_map_cat(std::move(tagMap), std::move(extra))); });
+                         });
+}
+
+void tag_map_cat_mixed(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    run_and_check_copies(state, { .copies = 2, .moves = 1 }, [&]
+                         {
+                             annotation extra(copy_move_counted(3));
+                             return count_copies([&] { benchmark::DoNotOptimize(ctmap::tag_map_cat(tagMap, std::move(extra))); });
+                         });
+}
+
+void tag_map_cut_lvalue(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    run_and_check_copies(state, { .copies = 1, .moves = 0 }, [&]
+                         {
+                             return count_copies([&] { benchmark::DoNotOptimize(ctmap::tag_map_cut<"name", "quantity">(tagMap)); });
+                         });
+}
+
+void tag_map_cut_rvalue(benchmark::State& state)
+{
+    run_and_check_copies(state, { .copies = 0, .moves = 1 }, [&]
+                         {
+                             auto tagMap = make_record();
+                             return count_copies([&] { benchmark::DoNotOptimize(ctmap::tag_map_cut<"name", "quantity">(std::move(tagMap))); });
+                         });
+}
+
+void make_tag_map_mixed(benchmark::State& state)
+{
+    copy_move_counted const id(1);
+    run_and_check_copies(state, { .copies = 1, .moves = 1 }, [&]
+                         {
+                             return count_copies([&]
+                                                 {
+                                                     benchmark::DoNotOptimize(ctmap::make_tag_map<"id", "name", "quantity">(id, std::string("name"), copy_move_counted(2)));
+                                                 });
+                         });
+}
+
+void converting_constructor_lvalue(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    run_and_check_copies(state, { .copies = 2, .moves = 0 }, [&]
+                         {
+                             return count_copies([&] { benchmark::DoNotOptimize(packed_record(tagMap)); });
+                         });
+}
+
+void converting_constructor_rvalue(benchmark::State& state)
+{
+    run_and_check_copies(state, { .copies = 0, .moves = 2 }, [&]
+                         {
+                             auto tagMap = make_record();
+                             return count_copies([&] { benchmark::DoNotOptimize(packed_record(std::move(tagMap))); });
+                         });
+}
+}
+
+BENCHMARK(tag_map_cat_lvalues);
+BENCHMARK(tag_map_cat_rvalues);
+BENCHMARK(tag_map_cat_mixed);
+BENCHMARK(tag_map_cut_lvalue);
+BENCHMARK(tag_map_cut_rvalue);
+BENCHMARK(make_tag_map_mixed);
+BENCHMARK(converting_constructor_lvalue);
+BENCHMARK(converting_constructor_rvalue);
@@ -0,0 +1,98 @@
+#include "../include/hash.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"tenant", std::uint32_t>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"balance", double>
+>;
+
+struct record_key
+{
+    std::uint64_t id;
+    std::uint32_t tenant;
+
+    bool operator==(record_key const&) const = default;
+};
+
+struct record_key_hash
+{
+    size_t operator()(record_key const& key) const noexcept
+    {
+        return std::hash<std::uint64_t>()(key.id) ^ (std::hash<std::uint32_t>()(key.tenant) << 1);
+    }
+};
+
+std::vector<record> make_records(size_t count)
+{
+    std::vector<record> records;
+    records.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+        records.emplace_back(std::uint64_t(index * 7919), std::uint32_t(index % 64), std::string("customer"), double(index));
+    return records;
+}
+
+void insert_tag_index(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        ctmap::tag_index<"id", "tenant"> index;
+        for (auto row = 0uz; row < records.size(); ++row)
+            index.insert(records, row);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void insert_unordered_map(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    for (auto _ : state)
+    {
+        std::unordered_map<record_key, size_t, record_key_hash> index;
+        for (auto row = 0uz; row < records.size(); ++row)
+            index.emplace(record_key{ .id = records[row].get<"id">(), .tenant = records[row].get<"tenant">() }, row);
+        benchmark::DoNotOptimize(index.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void find_tag_index(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    ctmap::tag_index<"id", "tenant"> const index(records);
+    for (auto _ : state)
+        for (auto row = 0uz; row < records.size(); row += 3)
+            benchmark::DoNotOptimize(index.find(records, ctmap::make_tag_map<"id", "tenant">(std::uint64_t(row * 7919), std::uint32_t(row % 64))));
+    state.SetItemsProcessed(state.iterations() * ((state.range(0) + 2) / 3));
+}
+
+void find_unordered_map(benchmark::State& state)
+{
+    auto const records = make_records(size_t(state.range(0)));
+    std::unordered_map<record_key, size_t, record_key_hash> index;
+    for (auto row = 0uz; row < records.size(); ++row)
+        index.emplace(record_key{ .id = records[row].get<"id">(), .tenant = records[row].get<"tenant">() }, row);
+    for (auto _ : state)
+        for (auto row = 0uz; row < records.size(); row += 3)
+            benchmark::DoNotOptimize(index.find(record_key{ .id = std::uint64_t(row * 7919), .tenant = std::uint32_t(row % 64) }));
+    state.SetItemsProcessed(state.iterations() * ((state.range(0) + 2) / 3));
+}
+}
+
+BENCHMARK(insert_tag_index)->Range(1 << 10, 1 << 18);
+BENCHMARK(insert_unordered_map)->Range(1 << 10, 1 << 18);
+BENCHMARK(find_tag_index)->Range(1 << 10, 1 << 18);
+BENCHMARK(find_unordered_map)->Range(1 << 10, 1 << 18);
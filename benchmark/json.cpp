@@ -0,0 +1,80 @@
+#include "../include/json.h"
+
+#include <benchmark/benchmark.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+template<typename _NameType>
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"name", _NameType>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"discount", std::optional<double>>,
+    ctmap::tagged_value<"active", bool>,
+    ctmap::tagged_value<"tags", std::vector<_NameType>>
+>;
+
+template<typename _NameType>
+using document = ctmap::tag_map<
+    ctmap::tagged_value<"version", int>,
+    ctmap::tagged_value<"records", std::vector<record<_NameType>>>
+>;
+
+std::string const& large_document()
+{
+    static std::string const json = []
+    {
+        document<std::string> result;
+        result.get<"version">() = 1;
+        for (auto index = 0uz; index < 100'000; ++index)
+            result.get<"records">().emplace_back(std::uint64_t(index),
+                                                 "record " + std::to_string(index),
+                                                 double(index) * 0.5,
+                                                 index % 2 ? std::optional<double>(0.1) : std::nullopt,
+                                                 index % 3 == 0,
+                                                 std::vector<std::string>{ "red", "green" });
+        return ctmap::to_json(result);
+    }();
+    return json;
+}
+
+void write_large_document(benchmark::State& state)
+{
+    auto const parsed = ctmap::from_json<document<std::string>>(large_document());
+    std::string out;
+    for (auto _ : state)
+    {
+        out.clear();
+        ctmap::to_json(parsed, std::back_inserter(out));
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(state.iterations() * large_document().size());
+}
+
+template<typename _NameType>
+void read_large_document(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::from_json<document<_NameType>>(large_document()));
+    state.SetBytesProcessed(state.iterations() * large_document().size());
+}
+
+void read_large_document_skipping_unknown_keys(benchmark::State& state)
+{
+    using version_only = ctmap::tag_map<ctmap::tagged_value<"version", int>>;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::from_json<version_only>(large_document()));
+    state.SetBytesProcessed(state.iterations() * large_document().size());
+}
+}
+
+BENCHMARK(write_large_document)->Unit(benchmark::kMillisecond);
+BENCHMARK(read_large_document<std::string>)->Unit(benchmark::kMillisecond);
+BENCHMARK(read_large_document<std::string_view>)->Unit(benchmark::kMillisecond);
+BENCHMARK(read_large_document_skipping_unknown_keys)->Unit(benchmark::kMillisecond);
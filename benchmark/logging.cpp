@@ -0,0 +1,133 @@
+#include <version>
+#if defined(__cpp_lib_format)
+#include "../include/logging.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace
+{
+struct file_closer
+{
+    void operator()(std::FILE* file) const
+    {
+        std::fclose(file);
+    }
+};
+
+using file_pointer = std::unique_ptr<std::FILE, file_closer>;
+
+auto make_request_log(std::int64_t index)
+{
+    return ctmap::make_tag_map<"timestamp", "level", "latency", "status", "path", "cached">(
+        1700000000123ll + index,
+        std::string_view("info"),
+        0.125,
+        200u,
+        std::string("/api/v1/records/") + std::to_string(index % 1000),
+        (index & 1) == 0
+    );
+}
+
+/**
+* Latencies of the timed calls, reported as p50 and p99 once the benchmark is done.
+*/
+class latency_histogram
+{
+public:
+
+    template<typename _Function>
+    void time(_Function&& function)
+    {
+        auto const begin = std::chrono::steady_clock::now();
+        function();
+        samples.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count());
+    }
+
+    void report(benchmark::State& state)
+    {
+        if (samples.empty())
+            return;
+        state.counters["p50_ns"] = percentile(0.5);
+        state.counters["p99_ns"] = percentile(0.99);
+    }
+
+private:
+
+    double percentile(double fraction)
+    {
+        auto const nth = samples.begin() + std::ptrdiff_t(fraction * double(samples.size() - 1));
+        std::ranges::nth_element(samples, nth);
+        return *nth;
+    }
+
+    std::vector<double> samples;
+};
+
+// request handling between two log lines, not timed
+void simulate_work(std::int64_t nanoseconds)
+{
+    auto const until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(nanoseconds);
+    while (std::chrono::steady_clock::now() < until)
+        ;
+}
+
+void log_direct_format_and_write(benchmark::State& state)
+{
+    file_pointer const file(std::fopen("/dev/null", "w"));
+    latency_histogram histogram;
+    std::string line;
+    auto index = 0ll;
+    for (auto _ : state)
+    {
+        auto const tagMap = make_request_log(index++);
+        histogram.time([&]
+                       {
+                           line.clear();
+                           std::format_to(std::back_inserter(line), "{}\n", tagMap);
+                           std::fwrite(line.data(), 1, line.size(), file.get());
+                       });
+        simulate_work(state.range(0));
+    }
+    histogram.report(state);
+}
+
+void log_deferred(benchmark::State& state)
+{
+    file_pointer const file(std::fopen("/dev/null", "w"));
+    latency_histogram histogram;
+    auto index = 0ll;
+    {
+        ctmap::tag_map_logger logger([&](std::string_view lines)
+                                     {
+                                         std::fwrite(lines.data(), 1, lines.size(), file.get());
+                                     });
+        for (auto _ : state)
+        {
+            auto const tagMap = make_request_log(index++);
+            histogram.time([&]
+                           {
+                               logger.log(tagMap);
+                           });
+            simulate_work(state.range(0));
+        }
+        logger.flush();
+    }
+    histogram.report(state);
+}
+}
+
+BENCHMARK(log_direct_format_and_write)->Arg(0)->Arg(1000);
+BENCHMARK(log_deferred)->Arg(0)->Arg(1000);
+#endif
@@ -0,0 +1,52 @@
+#include "../include/ctmap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+
+namespace
+{
+using declared_record = ctmap::tag_map<
+    ctmap::tagged_value<"active", bool>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int16_t>,
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"flagged", bool>
+>;
+
+using packed_record = ctmap::packed_tag_map<
+    ctmap::tagged_value<"active", bool>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int16_t>,
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"flagged", bool>
+>;
+
+static_assert(sizeof(declared_record) == 40);
+static_assert(sizeof(packed_record) == 24);
+
+template<typename _Record>
+void scan_price(benchmark::State& state)
+{
+    std::vector<_Record> records;
+    records.reserve(state.range(0));
+    for (auto index = 0uz; index < size_t(state.range(0)); ++index)
+        records.emplace_back(index % 3 == 0, double(index % 1000) * 0.25, std::int16_t(index % 17), std::uint64_t(index), false);
+
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto const& tagMap : records)
+            if (tagMap.template get<"active">())
+                sum += tagMap.template get<"price">();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes_per_record"] = sizeof(_Record);
+}
+}
+
+BENCHMARK(scan_price<declared_record>)->Range(1 << 10, 1 << 20);
+BENCHMARK(scan_price<packed_record>)->Range(1 << 10, 1 << 20);
@@ -0,0 +1,88 @@
+#include "../include/parallel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>
+>;
+
+std::vector<record> const& records()
+{
+    static auto const result = []
+    {
+        std::vector<record> records;
+        for (auto index = 0uz; index < 1uz << 22; ++index)
+            records.emplace_back(std::uint64_t(index), std::string("record"), double(index % 1000) * 0.25, std::int32_t(index % 17));
+        return records;
+    }();
+    return result;
+}
+
+double revenue(double price, std::int32_t quantity)
+{
+    return std::sqrt(price) * quantity;
+}
+
+void transform_reduce_serial_apply(benchmark::State& state)
+{
+    auto const& tagMaps = records();
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto const& tagMap : tagMaps)
+            sum += tagMap.apply<"price", "quantity">(revenue);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * tagMaps.size());
+}
+
+void transform_reduce_thread_pool(benchmark::State& state)
+{
+    auto const& tagMaps = records();
+    ctmap::thread_pool pool(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::parallel_transform_reduce<"price", "quantity">(pool, tagMaps, 0., std::plus<>(), revenue));
+    state.SetItemsProcessed(state.iterations() * tagMaps.size());
+}
+
+void transform_reduce_execution_policy(benchmark::State& state)
+{
+    auto const& tagMaps = records();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::parallel_transform_reduce<"price", "quantity">(std::execution::par, tagMaps, 0., std::plus<>(), revenue));
+    state.SetItemsProcessed(state.iterations() * tagMaps.size());
+}
+
+void for_each_thread_pool(benchmark::State& state)
+{
+    ctmap::thread_pool pool(state.range(0));
+    auto copy = records();
+    for (auto _ : state)
+    {
+        ctmap::parallel_for_each<"price">(pool, copy, [](double& price)
+                                          {
+                                              price = std::sqrt(price + 1.);
+                                          });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * copy.size());
+}
+}
+
+BENCHMARK(transform_reduce_serial_apply)->UseRealTime();
+BENCHMARK(transform_reduce_thread_pool)->DenseRange(1, std::max(std::thread::hardware_concurrency(), 1u))->UseRealTime();
+BENCHMARK(transform_reduce_execution_policy)->UseRealTime();
+BENCHMARK(for_each_thread_pool)->DenseRange(1, std::max(std::thread::hardware_concurrency(), 1u))->UseRealTime();
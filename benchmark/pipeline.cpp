@@ -0,0 +1,96 @@
+#include "../include/pipeline.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"revenue", double>,
+    ctmap::tagged_value<"discount", double>,
+    ctmap::tagged_value<"tax", double>,
+    ctmap::tagged_value<"total", double>
+>;
+
+std::vector<record> make_records()
+{
+    std::vector<record> records;
+    for (auto index = 0uz; index < 1uz << 20; ++index)
+        records.emplace_back(double(index % 1000) * 0.25, std::int32_t(index % 17), 0., 0., 0., 0.);
+    return records;
+}
+
+// revenue, discount and tax only read price and quantity, so they run concurrently, total waits for all three
+// lambdas rather than functions, so neither side pays for calls through function pointers
+auto const revenue = [](double price,
+                        std::int32_t quantity,
+                        double& result)
+{
+    result = std::sqrt(price) * quantity;
+};
+
+auto const discount = [](double price,
+                         std::int32_t quantity,
+                         double& result)
+{
+    result = std::exp(-price / 250.) * std::log1p(quantity);
+};
+
+auto const tax = [](double price,
+                    double& result)
+{
+    result = std::cbrt(price) * 0.19;
+};
+
+auto const total = [](double revenue,
+                      double discount,
+                      double tax,
+                      double& result)
+{
+    result = revenue * (1. - discount) + tax;
+};
+
+void sequential_apply_chain(benchmark::State& state)
+{
+    auto tagMaps = make_records();
+    for (auto _ : state)
+    {
+        for (auto& tagMap : tagMaps)
+        {
+            tagMap.apply<"price", "quantity", "revenue">(revenue);
+            tagMap.apply<"price", "quantity", "discount">(discount);
+            tagMap.apply<"price", "tax">(tax);
+            tagMap.apply<"revenue", "discount", "tax", "total">(total);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * tagMaps.size());
+}
+
+void pipeline_thread_pool(benchmark::State& state)
+{
+    using namespace ctmap;
+    auto tagMaps = make_records();
+    thread_pool pool(state.range(0));
+    auto pipeline = make_pipeline<record>(stage<reads<"price", "quantity">, writes<"revenue">>(revenue),
+                                          stage<reads<"price", "quantity">, writes<"discount">>(discount),
+                                          stage<reads<"price">, writes<"tax">>(tax),
+                                          stage<reads<"revenue", "discount", "tax">, writes<"total">>(total));
+    for (auto _ : state)
+    {
+        pipeline.run(pool, tagMaps);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * tagMaps.size());
+}
+}
+
+BENCHMARK(sequential_apply_chain)->UseRealTime();
+BENCHMARK(pipeline_thread_pool)->DenseRange(1, std::max(std::thread::hardware_concurrency(), 1u))->UseRealTime();
@@ -0,0 +1,116 @@
+#include "../include/serialization.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+using trivial_record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"active", bool>
+>;
+
+using string_record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"discount", std::optional<double>>,
+    ctmap::tagged_value<"history", std::vector<float>>
+>;
+
+std::vector<trivial_record> make_trivial_records(size_t count)
+{
+    std::vector<trivial_record> records;
+    records.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+        records.emplace_back(std::uint64_t(index), double(index) * 0.5, std::int32_t(index % 100), index % 2 == 0);
+    return records;
+}
+
+std::vector<string_record> make_string_records(size_t count)
+{
+    std::vector<string_record> records;
+    records.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+        records.emplace_back(std::uint64_t(index),
+                             "record " + std::to_string(index),
+                             index % 2 ? std::optional<double>(0.1) : std::nullopt,
+                             std::vector<float>(index % 8, 1.f));
+    return records;
+}
+
+template<typename _Record>
+void serialize_batch(benchmark::State& state,
+                     std::vector<_Record> const& records)
+{
+    std::vector<std::byte> buffer;
+    for (auto _ : state)
+    {
+        buffer.clear();
+        ctmap::serialize(std::span<_Record const>(records), buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+    state.SetItemsProcessed(state.iterations() * records.size());
+}
+
+template<typename _Record>
+void deserialize_batch(benchmark::State& state,
+                       std::vector<_Record> const& records)
+{
+    auto const buffer = ctmap::serialize(std::span<_Record const>(records));
+    for (auto _ : state)
+    {
+        auto roundTrip = ctmap::deserialize_batch<_Record>(buffer);
+        benchmark::DoNotOptimize(roundTrip.data());
+    }
+    if (ctmap::deserialize_batch<_Record>(buffer) != records)
+        state.SkipWithError("round trip changed the records");
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+    state.SetItemsProcessed(state.iterations() * records.size());
+}
+
+void serialize_trivial_records(benchmark::State& state)
+{
+    serialize_batch(state, make_trivial_records(state.range(0)));
+}
+
+void deserialize_trivial_records(benchmark::State& state)
+{
+    deserialize_batch(state, make_trivial_records(state.range(0)));
+}
+
+void serialize_string_records(benchmark::State& state)
+{
+    serialize_batch(state, make_string_records(state.range(0)));
+}
+
+void deserialize_string_records(benchmark::State& state)
+{
+    deserialize_batch(state, make_string_records(state.range(0)));
+}
+
+void round_trip_single_record(benchmark::State& state)
+{
+    auto const record = make_string_records(8).back();
+    std::vector<std::byte> buffer;
+    for (auto _ : state)
+    {
+        buffer.clear();
+        ctmap::serialize(record, buffer);
+        benchmark::DoNotOptimize(ctmap::deserialize<string_record>(buffer));
+    }
+}
+}
+
+BENCHMARK(serialize_trivial_records)->Arg(100'000);
+BENCHMARK(deserialize_trivial_records)->Arg(100'000);
+BENCHMARK(serialize_string_records)->Arg(100'000);
+BENCHMARK(deserialize_string_records)->Arg(100'000);
+BENCHMARK(round_trip_single_record);
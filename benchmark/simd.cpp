@@ -0,0 +1,172 @@
+#include "../include/simd.h"
+#include "../include/tag_map_vector.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"weight", float>
+>;
+
+record make_record(size_t index)
+{
+    return record(std::uint64_t(index), double(index % 1000) * 0.25, std::int32_t(index % 17), float(index % 13) * 0.5f);
+}
+
+std::vector<record> make_records(size_t count)
+{
+    std::vector<record> records;
+    records.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+        records.push_back(make_record(index));
+    return records;
+}
+
+ctmap::tag_map_vector_from_tag_map_t<record> make_columns(size_t count)
+{
+    ctmap::tag_map_vector_from_tag_map_t<record> columns;
+    columns.reserve(count);
+    for (auto index = 0uz; index < count; ++index)
+        columns.push_back(make_record(index));
+    return columns;
+}
+
+void sum_apply(benchmark::State& state)
+{
+    auto const records = make_records(state.range(0));
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto const& tagMap : records)
+            tagMap.apply<"price">([&](double price)
+                                  {
+                                      sum += price;
+                                  });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void sum_column_loop(benchmark::State& state)
+{
+    auto const columns = make_columns(state.range(0));
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto price : columns.column<"price">())
+            sum += price;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void sum_column_simd(benchmark::State& state)
+{
+    auto const columns = make_columns(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::column_sum<"price">(columns));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void max_apply(benchmark::State& state)
+{
+    auto const records = make_records(state.range(0));
+    for (auto _ : state)
+    {
+        float max = records.front().get<"weight">();
+        for (auto const& tagMap : records)
+            tagMap.apply<"weight">([&](float weight)
+                                   {
+                                       max = max < weight ? weight : max;
+                                   });
+        benchmark::DoNotOptimize(max);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void max_column_simd(benchmark::State& state)
+{
+    auto const columns = make_columns(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::column_max<"weight">(columns));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void transform_apply(benchmark::State& state)
+{
+    auto records = make_records(state.range(0));
+    for (auto _ : state)
+    {
+        for (auto& tagMap : records)
+            tagMap.apply<"quantity">([](std::int32_t& quantity)
+                                     {
+                                         quantity = quantity * 3 + 1;
+                                     });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void transform_column_simd(benchmark::State& state)
+{
+    auto columns = make_columns(state.range(0));
+    for (auto _ : state)
+    {
+        ctmap::column_transform<"quantity">(columns, [](std::int32_t quantity)
+                                            {
+                                                return quantity * 3 + 1;
+                                            });
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void filter_apply(benchmark::State& state)
+{
+    auto const records = make_records(state.range(0));
+    std::vector<double> result;
+    result.reserve(records.size());
+    for (auto _ : state)
+    {
+        result.clear();
+        for (auto const& tagMap : records)
+            tagMap.apply<"price">([&](double price)
+                                  {
+                                      if (price > 125.)
+                                          result.push_back(price);
+                                  });
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void filter_column_simd(benchmark::State& state)
+{
+    auto const columns = make_columns(state.range(0));
+    std::vector<double> result(columns.size());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctmap::simd_filter(columns.column<"price">(), std::span(result), [](double price)
+                                                    {
+                                                        return price > 125.;
+                                                    }));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(sum_apply)->Range(1 << 10, 1 << 20);
+BENCHMARK(sum_column_loop)->Range(1 << 10, 1 << 20);
+BENCHMARK(sum_column_simd)->Range(1 << 10, 1 << 20);
+BENCHMARK(max_apply)->Range(1 << 10, 1 << 20);
+BENCHMARK(max_column_simd)->Range(1 << 10, 1 << 20);
+BENCHMARK(transform_apply)->Range(1 << 10, 1 << 20);
+BENCHMARK(transform_column_simd)->Range(1 << 10, 1 << 20);
+BENCHMARK(filter_apply)->Range(1 << 10, 1 << 20);
+BENCHMARK(filter_column_simd)->Range(1 << 10, 1 << 20);
@@ -0,0 +1,78 @@
+#include "../include/sparse_tag_map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+
+namespace
+{
+using optional_record = ctmap::tag_map<
+    ctmap::tagged_value<"price", std::optional<double>>,
+    ctmap::tagged_value<"quantity", std::optional<std::int32_t>>,
+    ctmap::tagged_value<"discount", std::optional<float>>,
+    ctmap::tagged_value<"flagged", std::optional<bool>>
+>;
+
+using sparse_record = ctmap::sparse_tag_map<
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"discount", float>,
+    ctmap::tagged_value<"flagged", bool>
+>;
+
+static_assert(sizeof(optional_record) == 40);
+static_assert(sizeof(sparse_record) == 24);
+
+void fill(optional_record& record,
+          size_t index)
+{
+    if (index % 2 == 0)
+        record.get<"price">() = double(index % 1000) * 0.25;
+    if (index % 3 == 0)
+        record.get<"quantity">() = std::int32_t(index % 17);
+}
+
+void fill(sparse_record& record,
+          size_t index)
+{
+    if (index % 2 == 0)
+        record.emplace<"price">(double(index % 1000) * 0.25);
+    if (index % 3 == 0)
+        record.emplace<"quantity">(std::int32_t(index % 17));
+}
+
+double price(optional_record const& record)
+{
+    return record.get<"price">().value_or(0.);
+}
+
+double price(sparse_record const& record)
+{
+    auto const* value = record.get_if<"price">();
+    return value ? *value : 0.;
+}
+
+template<typename _Record>
+void scan_price(benchmark::State& state)
+{
+    std::vector<_Record> records(state.range(0));
+    for (auto index = 0uz; index < records.size(); ++index)
+        fill(records[index], index);
+
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto const& record : records)
+            sum += price(record);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes_per_record"] = sizeof(_Record);
+}
+}
+
+BENCHMARK(scan_price<optional_record>)->Range(1 << 10, 1 << 20);
+BENCHMARK(scan_price<sparse_record>)->Range(1 << 10, 1 << 20);
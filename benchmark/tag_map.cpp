@@ -0,0 +1,314 @@
+#include <version>
+#include "../include/ctmap.h"
+#if defined(__cpp_lib_format)
+#include "../include/formatter.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+using record_tag_map = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::int64_t>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"active", bool>
+>;
+
+using record_tuple = std::tuple<std::int64_t, double, std::int32_t, std::string, bool>;
+
+struct record_struct
+{
+    std::int64_t id;
+    double price;
+    std::int32_t quantity;
+    std::string name;
+    bool active;
+};
+
+constexpr auto recordCount = 1024uz;
+
+std::string make_name(size_t index)
+{
+    return "article-" + std::to_string(index);
+}
+
+template<typename _Record>
+std::vector<_Record> make_records()
+{
+    std::vector<_Record> records;
+    records.reserve(recordCount);
+    for (auto index = 0uz; index < recordCount; ++index)
+        records.push_back(_Record{ std::int64_t(index), double(index) * 0.5, std::int32_t(index % 17), make_name(index), index % 3 == 0 });
+    return records;
+}
+
+template<>
+std::vector<record_tag_map> make_records<record_tag_map>()
+{
+    std::vector<record_tag_map> records;
+    records.reserve(recordCount);
+    for (auto index = 0uz; index < recordCount; ++index)
+        records.emplace_back(std::int64_t(index), double(index) * 0.5, std::int32_t(index % 17), make_name(index), index % 3 == 0);
+    return records;
+}
+
+// get<"tag">, get<Index> and the struct member access should compile to the same loads
+void get_by_tag_tag_map(benchmark::State& state)
+{
+    auto const records = make_records<record_tag_map>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(double(record.get<"id">()) + record.get<"price">() * record.get<"quantity">() + double(record.get<"active">()));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void get_by_index_tag_map(benchmark::State& state)
+{
+    auto const records = make_records<record_tag_map>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(double(record.get<0>().value) + record.get<1>().value * record.get<2>().value + double(record.get<4>().value));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void get_by_index_tuple(benchmark::State& state)
+{
+    auto const records = make_records<record_tuple>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(double(std::get<0>(record)) + std::get<1>(record) * std::get<2>(record) + double(std::get<4>(record)));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void get_member_struct(benchmark::State& state)
+{
+    auto const records = make_records<record_struct>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(double(record.id) + record.price * record.quantity + double(record.active));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+struct sum_numbers
+{
+    double operator()(std::int64_t id,
+                      double price,
+                      std::int32_t quantity,
+                      std::string const& name,
+                      bool active) const noexcept
+    {
+        return double(id) + price * quantity + double(name.size()) + double(active);
+    }
+};
+
+void apply_tag_map(benchmark::State& state)
+{
+    auto const records = make_records<record_tag_map>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(record.apply<ctmap::all_tags>(sum_numbers()));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void apply_tuple(benchmark::State& state)
+{
+    auto const records = make_records<record_tuple>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(std::apply(sum_numbers(), record));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void apply_struct(benchmark::State& state)
+{
+    auto const records = make_records<record_struct>();
+    for (auto _ : state)
+        for (auto const& record : records)
+            benchmark::DoNotOptimize(sum_numbers()(record.id, record.price, record.quantity, record.name, record.active));
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void make_tag_map(benchmark::State& state)
+{
+    auto index = 0ll;
+    for (auto _ : state)
+    {
+        auto record = ctmap::make_tag_map<"id", "price", "quantity", "name", "active">(++index, 0.5, 3, std::string("article"), true);
+        benchmark::DoNotOptimize(record);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void make_tuple(benchmark::State& state)
+{
+    auto index = 0ll;
+    for (auto _ : state)
+    {
+        auto record = std::make_tuple(++index, 0.5, 3, std::string("article"), true);
+        benchmark::DoNotOptimize(record);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void make_struct(benchmark::State& state)
+{
+    auto index = 0ll;
+    for (auto _ : state)
+    {
+        auto record = record_struct{ .id = ++index, .price = 0.5, .quantity = 3, .name = std::string("article"), .active = true };
+        benchmark::DoNotOptimize(record);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+struct key_struct
+{
+    std::int64_t id;
+    std::string name;
+};
+
+struct record_with_origin_struct
+{
+    record_struct record;
+    std::string origin;
+};
+
+void tag_map_cut(benchmark::State& state)
+{
+    auto const records = make_records<record_tag_map>();
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            auto key = ctmap::tag_map_cut<"id", "name">(record);
+            benchmark::DoNotOptimize(key);
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void cut_tuple(benchmark::State& state)
+{
+    auto const records = make_records<record_tuple>();
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            auto key = std::make_tuple(std::get<0>(record), std::get<3>(record));
+            benchmark::DoNotOptimize(key);
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void cut_struct(benchmark::State& state)
+{
+    auto const records = make_records<record_struct>();
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            auto key = key_struct{ .id = record.id, .name = record.name };
+            benchmark::DoNotOptimize(key);
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void tag_map_cat(benchmark::State& state)
+{
+    auto const records = make_records<record_tag_map>();
+    auto const origin = ctmap::make_tag_map<"origin">(std::string("warehouse"));
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            auto combined = ctmap::tag_map_cat(record, origin);
+            benchmark::DoNotOptimize(combined);
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void cat_tuple(benchmark::State& state)
+{
+    auto const records = make_records<record_tuple>();
+    auto const origin = std::make_tuple(std::string("warehouse"));
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            auto combined = std::tuple_cat(record, origin);
+            benchmark::DoNotOptimize(combined);
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void cat_struct(benchmark::State& state)
+{
+    auto const records = make_records<record_struct>();
+    std::string const origin("warehouse");
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            auto combined = record_with_origin_struct{ .record = record, .origin = origin };
+            benchmark::DoNotOptimize(combined);
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+#if defined(__cpp_lib_format)
+void format_tag_map(benchmark::State& state)
+{
+    auto const records = make_records<record_tag_map>();
+    std::string buffer;
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            buffer.clear();
+            std::format_to(std::back_inserter(buffer), "{}", record);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+
+void format_struct(benchmark::State& state)
+{
+    auto const records = make_records<record_struct>();
+    std::string buffer;
+    for (auto _ : state)
+        for (auto const& record : records)
+        {
+            buffer.clear();
+            std::format_to(std::back_inserter(buffer), "{{id: {}, price: {}, quantity: {}, name: {}, active: {}}}",
+                           record.id, record.price, record.quantity, record.name, record.active);
+            benchmark::DoNotOptimize(buffer.data());
+        }
+    state.SetItemsProcessed(state.iterations() * recordCount);
+}
+#endif
+}
+
+BENCHMARK(get_by_tag_tag_map);
+BENCHMARK(get_by_index_tag_map);
+BENCHMARK(get_by_index_tuple);
+BENCHMARK(get_member_struct);
+BENCHMARK(apply_tag_map);
+BENCHMARK(apply_tuple);
+BENCHMARK(apply_struct);
+BENCHMARK(make_tag_map);
+BENCHMARK(make_tuple);
+BENCHMARK(make_struct);
+BENCHMARK(tag_map_cut);
+BENCHMARK(cut_tuple);
+BENCHMARK(cut_struct);
+BENCHMARK(tag_map_cat);
+BENCHMARK(cat_tuple);
+BENCHMARK(cat_struct);
+#if defined(__cpp_lib_format)
+BENCHMARK(format_tag_map);
+BENCHMARK(format_struct);
+#endif
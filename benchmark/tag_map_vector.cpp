@@ -0,0 +1,109 @@
+#include "../include/tag_map_vector.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::uint64_t>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"price", double>,
+    ctmap::tagged_value<"quantity", std::int32_t>,
+    ctmap::tagged_value<"active", bool>
+>;
+
+record make_record(size_t index)
+{
+    return record(std::uint64_t(index),
+                  std::string("record name ") + std::to_string(index),
+                  double(index % 1000) * 0.25,
+                  std::int32_t(index % 17),
+                  index % 3 == 0);
+}
+
+void scan_price_vector_of_tag_maps(benchmark::State& state)
+{
+    std::vector<record> records;
+    records.reserve(state.range(0));
+    for (auto index = 0uz; index < size_t(state.range(0)); ++index)
+        records.push_back(make_record(index));
+
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto const& tagMap : records)
+            sum += tagMap.get<"price">();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void scan_price_tag_map_vector(benchmark::State& state)
+{
+    ctmap::tag_map_vector_from_tag_map_t<record> records;
+    records.reserve(state.range(0));
+    for (auto index = 0uz; index < size_t(state.range(0)); ++index)
+        records.push_back(make_record(index));
+
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto price : records.column<"price">())
+            sum += price;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void scan_price_tag_map_vector_rows(benchmark::State& state)
+{
+    ctmap::tag_map_vector_from_tag_map_t<record> records;
+    records.reserve(state.range(0));
+    for (auto index = 0uz; index < size_t(state.range(0)); ++index)
+        records.push_back(make_record(index));
+
+    for (auto _ : state)
+    {
+        double sum = 0.;
+        for (auto row : std::as_const(records))
+            sum += row.get<"price">();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void push_back_vector_of_tag_maps(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        std::vector<record> records;
+        for (auto index = 0uz; index < size_t(state.range(0)); ++index)
+            records.push_back(make_record(index));
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void push_back_tag_map_vector(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        ctmap::tag_map_vector_from_tag_map_t<record> records;
+        for (auto index = 0uz; index < size_t(state.range(0)); ++index)
+            records.push_back(make_record(index));
+        benchmark::DoNotOptimize(records.column<"id">().data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK(scan_price_vector_of_tag_maps)->Range(1 << 10, 1 << 20);
+BENCHMARK(scan_price_tag_map_vector)->Range(1 << 10, 1 << 20);
+BENCHMARK(scan_price_tag_map_vector_rows)->Range(1 << 10, 1 << 20);
+BENCHMARK(push_back_vector_of_tag_maps)->Range(1 << 10, 1 << 16);
+BENCHMARK(push_back_tag_map_vector)->Range(1 << 10, 1 << 16);
@@ -0,0 +1,57 @@
+#include "../include/ctmap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+
+namespace
+{
+using record = ctmap::tag_map<
+    ctmap::tagged_value<"id", std::string>,
+    ctmap::tagged_value<"name", std::string>,
+    ctmap::tagged_value<"description", std::string>,
+    ctmap::tagged_value<"category", std::string>,
+    ctmap::tagged_value<"price", double>
+>;
+
+record make_record()
+{
+    return record(std::string(40, 'i'),
+                  std::string(64, 'n'),
+                  std::string(256, 'd'),
+                  std::string(32, 'c'),
+                  9.99);
+}
+
+template<typename _TagMap>
+[[gnu::noinline]] size_t read_fields(_TagMap const& tagMap)
+{
+    return tagMap.template get<"name">().size() + tagMap.template get<"description">().size() + size_t(tagMap.template get<"price">());
+}
+
+void cut_and_read(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(read_fields(ctmap::tag_map_cut<"name", "description", "price">(tagMap)));
+}
+
+void view_and_read(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(read_fields(ctmap::tag_map_view<"name", "description", "price">(tagMap)));
+}
+
+void view_of_view_and_read(benchmark::State& state)
+{
+    auto const tagMap = make_record();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(read_fields(ctmap::tag_map_view<"name", "description", "price">(ctmap::tag_map_view(tagMap))));
+}
+}
+
+BENCHMARK(cut_and_read);
+BENCHMARK(view_and_read);
+BENCHMARK(view_of_view_and_read);
@@ -0,0 +1,102 @@
+#include "../include/serialization.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+constexpr size_t field_count = 50;
+
+template<size_t _Index>
+constexpr ctmap::char_tag<4> field_tag = []
+{
+    char const name[4] = { 'f', char('0' + _Index / 10), char('0' + _Index % 10), '\0' };
+    return ctmap::char_tag<4>(name);
+}();
+
+template<size_t _Index>
+using field_type_t = std::conditional_t<_Index % 8 == 7, std::string, std::conditional_t<_Index % 2 == 0, std::int64_t, double>>;
+
+template<template<typename...> typename _TagMap, size_t... _Indices>
+auto make_record_type(std::index_sequence<_Indices...>) -> _TagMap<ctmap::tagged_value<field_tag<_Indices>, field_type_t<_Indices>>...>;
+
+using plain_record = decltype(make_record_type<ctmap::tag_map>(std::make_index_sequence<field_count>()));
+using tracked_record = decltype(make_record_type<ctmap::tracked_tag_map>(std::make_index_sequence<field_count>()));
+
+template<size_t _Index>
+field_type_t<_Index> field_value()
+{
+    if constexpr (std::is_same_v<field_type_t<_Index>, std::string>)
+        return std::string(24, char('a' + _Index % 26));
+    else
+        return field_type_t<_Index>(_Index);
+}
+
+template<typename _Record>
+_Record make_record()
+{
+    return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        return _Record(field_value<_Indices>()...);
+    }(std::make_index_sequence<field_count>());
+}
+
+template<typename _Record>
+void update_two_fields(benchmark::State& state)
+{
+    std::vector<_Record> records(size_t(state.range(0)), make_record<_Record>());
+    for (auto _ : state)
+    {
+        for (auto& record : records)
+        {
+            ++record.template get<"f02">();
+            record.template get<"f13">() += 0.5;
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void serialize_full_snapshot(benchmark::State& state)
+{
+    auto record = make_record<tracked_record>();
+    std::vector<std::byte> buffer;
+    for (auto _ : state)
+    {
+        ++record.get<"f02">();
+        record.get<"f13">() += 0.5;
+        buffer.clear();
+        ctmap::serialize(record.values(), buffer);
+        record.clear_dirty();
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.counters["bytes_per_update"] = double(buffer.size());
+}
+
+void serialize_dirty_delta(benchmark::State& state)
+{
+    auto record = make_record<tracked_record>();
+    std::vector<std::byte> buffer;
+    for (auto _ : state)
+    {
+        ++record.get<"f02">();
+        record.get<"f13">() += 0.5;
+        buffer.clear();
+        ctmap::serialize_dirty(record, buffer);
+        record.clear_dirty();
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.counters["bytes_per_update"] = double(buffer.size());
+}
+}
+
+BENCHMARK(update_two_fields<plain_record>)->Range(1 << 10, 1 << 16);
+BENCHMARK(update_two_fields<tracked_record>)->Range(1 << 10, 1 << 16);
+BENCHMARK(serialize_full_snapshot);
+BENCHMARK(serialize_dirty_delta);
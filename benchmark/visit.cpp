@@ -0,0 +1,193 @@
+#include "../include/visit.h"
+
+#include <benchmark/benchmark.h>
+
+#include <any>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+
+namespace
+{
+auto make_benchmark_tag_map()
+{
+    return ctmap::make_tag_map<
+        "timestamp", "host", "port", "method", "path", "status", "latency", "bytesIn",
+        "bytesOut", "userAgent", "referer", "traceId", "spanId", "retries", "cached", "region"
+    >(1700000000ll, std::string("localhost"), 8080, std::string("GET"), std::string("/index.html"), 200, 0.125, 512ll,
+      4096ll, std::string("benchmark"), std::string("none"), 42ull, 7ull, 0, true, std::string("eu-west"));
+}
+
+using benchmark_tag_map = decltype(make_benchmark_tag_map());
+
+std::vector<std::string> const& lookup_keys()
+{
+    static std::vector<std::string> const keys = {
+        "timestamp", "status", "region", "latency", "unknown", "cached", "path", "bytesOut"
+    };
+    return keys;
+}
+
+struct size_visitor
+{
+    template<typename _ValueType>
+    size_t operator()(_ValueType const&) const noexcept
+    {
+        return sizeof(_ValueType);
+    }
+};
+
+template<typename _Function>
+size_t strcmp_chain(benchmark_tag_map const& tagMap,
+                    char const* key,
+                    _Function&& function)
+{
+    return ctmap::apply([&](auto const&... taggedValues)
+                        {
+                            size_t result = 0;
+                            ((std::strcmp(key, taggedValues.tag) == 0 && (result = function(taggedValues.value), true)) || ...);
+                            return result;
+                        },
+                        tagMap);
+}
+
+template<size_t _Index = 0, typename _Function>
+size_t recursive_if_constexpr(benchmark_tag_map const& tagMap,
+                              size_t index,
+                              _Function&& function)
+{
+    if constexpr (_Index == std::tuple_size_v<benchmark_tag_map>)
+        return 0;
+    else
+    {
+        if (index == _Index)
+            return function(tagMap.get<_Index>().value);
+        return recursive_if_constexpr<_Index + 1>(tagMap, index, function);
+    }
+}
+
+template<size_t _Index = 0>
+std::string_view recursive_tag_name(size_t index)
+{
+    if constexpr (_Index == std::tuple_size_v<benchmark_tag_map>)
+        return std::string_view();
+    else
+    {
+        if (index == _Index)
+            return benchmark_tag_map::index_tag<_Index>().view();
+        return recursive_tag_name<_Index + 1>(index);
+    }
+}
+
+std::vector<size_t> const& lookup_indices()
+{
+    static std::vector<size_t> const indices = []
+    {
+        std::vector<size_t> result(1024);
+        std::minstd_rand random(42);
+        for (auto& index : result)
+            index = random() % std::tuple_size_v<benchmark_tag_map>;
+        return result;
+    }();
+    return indices;
+}
+
+struct touch_visitor
+{
+    template<typename _ValueType>
+    size_t operator()(_ValueType const& value) const noexcept
+    {
+        benchmark::DoNotOptimize(value);
+        return sizeof(_ValueType);
+    }
+};
+
+void visit_index_jump_table(benchmark::State& state)
+{
+    auto const tagMap = make_benchmark_tag_map();
+    auto const& indices = lookup_indices();
+    for (auto _ : state)
+        for (auto index : indices)
+            benchmark::DoNotOptimize(ctmap::visit_index(tagMap, index, touch_visitor()).value_or(0));
+    state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+void visit_index_recursive_if_constexpr(benchmark::State& state)
+{
+    auto const tagMap = make_benchmark_tag_map();
+    auto const& indices = lookup_indices();
+    for (auto _ : state)
+        for (auto index : indices)
+            benchmark::DoNotOptimize(recursive_if_constexpr(tagMap, index, touch_visitor()));
+    state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+void tag_name_table(benchmark::State& state)
+{
+    auto const& indices = lookup_indices();
+    for (auto _ : state)
+        for (auto index : indices)
+            benchmark::DoNotOptimize(index < ctmap::tag_names<benchmark_tag_map>().size() ? ctmap::tag_names<benchmark_tag_map>()[index].size() : 0);
+    state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+void tag_name_recursive_if_constexpr(benchmark::State& state)
+{
+    auto const& indices = lookup_indices();
+    for (auto _ : state)
+        for (auto index : indices)
+            benchmark::DoNotOptimize(recursive_tag_name(index).size());
+    state.SetItemsProcessed(state.iterations() * indices.size());
+}
+
+void visit_perfect_hash(benchmark::State& state)
+{
+    auto const tagMap = make_benchmark_tag_map();
+    auto const& keys = lookup_keys();
+    for (auto _ : state)
+        for (auto const& key : keys)
+            benchmark::DoNotOptimize(ctmap::visit(tagMap, key, size_visitor()));
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void visit_strcmp_chain(benchmark::State& state)
+{
+    auto const tagMap = make_benchmark_tag_map();
+    auto const& keys = lookup_keys();
+    for (auto _ : state)
+        for (auto const& key : keys)
+            benchmark::DoNotOptimize(strcmp_chain(tagMap, key.c_str(), size_visitor()));
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void visit_unordered_map_any(benchmark::State& state)
+{
+    std::unordered_map<std::string, std::any> values;
+    ctmap::apply([&](auto const&... taggedValues)
+                 {
+                     (values.emplace(taggedValues.tag, taggedValues.value), ...);
+                 },
+                 make_benchmark_tag_map());
+    auto const& keys = lookup_keys();
+    for (auto _ : state)
+        for (auto const& key : keys)
+        {
+            auto const it = values.find(key);
+            benchmark::DoNotOptimize(it == values.end() ? 0 : it->second.type().hash_code());
+        }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+}
+
+BENCHMARK(visit_perfect_hash);
+BENCHMARK(visit_strcmp_chain);
+BENCHMARK(visit_unordered_map_any);
+BENCHMARK(visit_index_jump_table);
+BENCHMARK(visit_index_recursive_if_constexpr);
+BENCHMARK(tag_name_table);
+BENCHMARK(tag_name_recursive_if_constexpr);
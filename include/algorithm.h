@@ -0,0 +1,273 @@
+#pragma once
+#include "ctmap.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+template<std::ranges::random_access_range _Range>
+using range_row_t = std::remove_cvref_t<std::ranges::range_reference_t<_Range>>;
+
+/**
+* Values that map to unsigned integers of their size with the same order, so they can be radix sorted.
+*/
+template<typename _ValueType>
+concept RadixSortable = (std::integral<_ValueType> || std::is_enum_v<_ValueType> || (std::floating_point<_ValueType> && std::numeric_limits<_ValueType>::is_iec559))
+                        && sizeof(_ValueType) <= 8;
+
+template<RadixSortable _ValueType>
+constexpr std::uint64_t radix_key(_ValueType value) noexcept
+{
+    if constexpr (std::is_enum_v<_ValueType>)
+        return radix_key(std::to_underlying(value));
+    else if constexpr (std::same_as<_ValueType, bool>)
+        return value;
+    else if constexpr (std::floating_point<_ValueType>)
+    {
+        using bits_type = std::conditional_t<sizeof(_ValueType) == 4, std::uint32_t, std::uint64_t>;
+        // -0.0 and +0.0 compare equal, so they get the same key and stable sorting keeps their order
+        auto const bits = std::bit_cast<bits_type>(value == _ValueType(0) ? _ValueType(0) : value);
+        constexpr auto sign = bits_type(1) << (8 * sizeof(bits_type) - 1);
+        // negative values in reverse order below all positive ones
+        return (bits & sign) ? bits_type(~bits) : bits_type(bits | sign);
+    }
+    else
+    {
+        using unsigned_type = std::make_unsigned_t<_ValueType>;
+        auto const bits = unsigned_type(value);
+        if constexpr (std::is_signed_v<_ValueType>)
+            return unsigned_type(bits ^ (unsigned_type(1) << (8 * sizeof(_ValueType) - 1)));
+        else
+            return bits;
+    }
+}
+
+/**
+* Whether the values of the given tags of _TagMap fit into one 64 bit radix key together.
+*/
+template<typename _TagMap, char_tag... _Tags>
+constexpr bool is_radix_sortable_v = (RadixSortable<std::remove_cvref_t<decltype(std::declval<_TagMap const&>().template get<_Tags>())>> && ...)
+                                     && (sizeof(std::remove_cvref_t<decltype(std::declval<_TagMap const&>().template get<_Tags>())>) + ... + 0) <= 8;
+
+/**
+* The values of the given tags packed into one integer, the first tag in the most significant bits.
+*/
+template<char_tag... _Tags, typename _TagMap>
+constexpr std::uint64_t packed_radix_key(_TagMap const& tagMap) noexcept
+{
+    std::uint64_t result = 0;
+    ([&]
+     {
+         constexpr auto bits = 8 * sizeof(tagMap.template get<_Tags>());
+         if constexpr (bits == 64)
+             result = radix_key(tagMap.template get<_Tags>());
+         else
+             result = (result << bits) | radix_key(tagMap.template get<_Tags>());
+     }(), ...);
+    return result;
+}
+
+/**
+* Stable LSD radix sort of rows by their keys, one pass per key byte whose value is not the same for all rows.
+*/
+template<size_t _KeyBytes>
+void radix_sort(std::vector<std::uint64_t>& keys,
+                std::vector<size_t>& rows)
+{
+    std::vector<std::uint64_t> keyBuffer(keys.size());
+    std::vector<size_t> rowBuffer(rows.size());
+    for (auto byte = 0uz; byte < _KeyBytes; ++byte)
+    {
+        auto const shift = 8 * byte;
+        std::array<size_t, 256> offsets{};
+        for (auto key : keys)
+            ++offsets[(key >> shift) & 0xff];
+        if (std::ranges::find(offsets, keys.size()) != offsets.end())
+            continue;
+        std::exclusive_scan(offsets.begin(), offsets.end(), offsets.begin(), 0uz);
+        for (auto index = 0uz; index < keys.size(); ++index)
+        {
+            auto const position = offsets[(keys[index] >> shift) & 0xff]++;
+            keyBuffer[position] = keys[index];
+            rowBuffer[position] = rows[index];
+        }
+        keys.swap(keyBuffer);
+        rows.swap(rowBuffer);
+    }
+}
+
+/**
+* Reorders a contiguous sequence so that position i receives the element at sources[i], moving every element once.
+* sources is used as scratch space and left in an unspecified state.
+*/
+template<std::random_access_iterator _Iterator>
+void apply_permutation(_Iterator first,
+                       std::vector<size_t>& sources)
+{
+    for (auto start = 0uz; start < sources.size(); ++start)
+    {
+        if (sources[start] == start)
+            continue;
+        auto value = std::move(first[start]);
+        auto current = start;
+        while (sources[current] != start)
+        {
+            auto const next = sources[current];
+            first[current] = std::move(first[next]);
+            sources[current] = current;
+            current = next;
+        }
+        first[current] = std::move(value);
+        sources[current] = current;
+    }
+}
+
+/**
+* Reorders records, a random access range of tag maps, so that position i receives the record at sources[i].
+* Column stores like tag_map_vector are reordered column by column. Other ranges of views, which cannot be
+* assigned, reorder the values they refer to tag by tag.
+*/
+template<std::ranges::random_access_range _Range>
+void apply_permutation(_Range& records,
+                       std::vector<size_t> const& sources)
+{
+    using row_type = range_row_t<_Range>;
+    constexpr bool has_columns = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        return (requires { records.template column<std::tuple_element_t<_Indices, row_type>::tag>(); } && ...);
+    }(std::make_index_sequence<std::tuple_size_v<row_type>>());
+    if constexpr (has_columns || is_tag_map_view_v<row_type>)
+    {
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            ([&]
+             {
+                 auto scratch = sources;
+                 if constexpr (has_columns)
+                     apply_permutation(records.template column<std::tuple_element_t<_Indices, row_type>::tag>().begin(), scratch);
+                 else
+                 {
+                     auto values = records | std::views::transform([](auto&& row) -> auto&
+                                                                    {
+                                                                        return row.template get<std::tuple_element_t<_Indices, row_type>::tag>();
+                                                                    });
+                     apply_permutation(std::ranges::begin(values), scratch);
+                 }
+             }(), ...);
+        }(std::make_index_sequence<std::tuple_size_v<row_type>>());
+    }
+    else
+    {
+        auto scratch = sources;
+        apply_permutation(std::ranges::begin(records), scratch);
+    }
+}
+
+/**
+* Order of the rows of records after a stable sort by the values of the given tags, records itself is not changed.
+* Keys of up to 64 bits of integers, enums and floating point values are packed and radix sorted,
+* other keys are compared through the records, so only row numbers are moved while sorting.
+*/
+template<char_tag... _Tags, std::ranges::random_access_range _Range>
+std::vector<size_t> sorted_order_by(_Range const& records)
+{
+    static_assert(sizeof...(_Tags) > 0, "sorting needs at least one tag");
+    using row_type = range_row_t<_Range>;
+    auto const first = std::ranges::begin(records);
+    auto const count = size_t(std::ranges::distance(records));
+
+    std::vector<size_t> rows(count);
+    std::iota(rows.begin(), rows.end(), 0uz);
+    if constexpr (is_radix_sortable_v<row_type, _Tags...>)
+    {
+        std::vector<std::uint64_t> keys(count);
+        for (auto row = 0uz; row < count; ++row)
+            keys[row] = packed_radix_key<_Tags...>(first[row]);
+        radix_sort<(sizeof(std::remove_cvref_t<decltype(std::declval<row_type const&>().template get<_Tags>())>) + ...)>(keys, rows);
+    }
+    else
+        std::ranges::stable_sort(rows, [&](size_t lhs, size_t rhs)
+                                 {
+                                     auto const& lhsRow = first[lhs];
+                                     auto const& rhsRow = first[rhs];
+                                     return std::forward_as_tuple(lhsRow.template get<_Tags>()...) < std::forward_as_tuple(rhsRow.template get<_Tags>()...);
+                                 });
+    return rows;
+}
+
+/**
+* Stable sort of records by the values of the given tags, in the order of the tags.
+* The order is computed on row numbers and compact keys, then every record is moved once into place,
+* so wide records are not swapped around during the sort.
+*/
+template<char_tag... _Tags, std::ranges::random_access_range _Range>
+void sort_by(_Range&& records)
+{
+    apply_permutation(records, sorted_order_by<_Tags...>(records));
+}
+
+/**
+* Sorts records by the given tags and returns the ranges of consecutive records with equal values of these tags.
+*/
+template<char_tag... _Tags, std::ranges::random_access_range _Range>
+auto group_by(_Range&& records)
+{
+    sort_by<_Tags...>(records);
+    std::vector<std::ranges::subrange<std::ranges::iterator_t<_Range>>> groups;
+    auto const first = std::ranges::begin(records);
+    auto const count = std::ranges::distance(records);
+    for (std::ranges::range_difference_t<_Range> begin = 0, end = 0; begin < count; begin = end)
+    {
+        for (end = begin + 1; end < count && equal_tags<_Tags...>(first[begin], first[end]); ++end)
+        {}
+        groups.emplace_back(first + begin, first + end);
+    }
+    return groups;
+}
+
+/**
+* Stable partition of records into those predicate holds for and the rest.
+* predicate is called with the values of the given tags (all values if no tags are given) like tag_map::apply.
+* Returns the iterator to the first record predicate does not hold for.
+*/
+template<char_tag... _Tags, std::ranges::random_access_range _Range, typename _Predicate>
+auto partition_by(_Range&& records,
+                  _Predicate predicate)
+{
+    auto const first = std::ranges::begin(records);
+    auto const count = size_t(std::ranges::distance(records));
+    std::vector<size_t> sources(count);
+    auto front = sources.begin();
+    auto back = sources.rbegin();
+    for (auto row = 0uz; row < count; ++row)
+    {
+        auto&& record = first[row];
+        bool holds;
+        if constexpr (sizeof...(_Tags) == 0)
+            holds = record.template apply<all_tags>(predicate);
+        else
+            holds = record.template apply<_Tags...>(predicate);
+        if (holds)
+            *front++ = row;
+        else
+            *back++ = row;
+    }
+    auto const partitionPoint = front - sources.begin();
+    std::reverse(sources.begin() + partitionPoint, sources.end());
+    apply_permutation(records, sources);
+    return std::ranges::begin(records) + partitionPoint;
+}
+}
@@ -0,0 +1,351 @@
+#pragma once
+#include "ctmap.h"
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+template<typename _Operation, typename _Lhs, typename _Rhs>
+class tag_map_expression;
+
+template<typename>
+struct is_tag_map_expression : std::false_type
+{};
+
+template<typename _Operation, typename _Lhs, typename _Rhs>
+struct is_tag_map_expression<tag_map_expression<_Operation, _Lhs, _Rhs>> : std::true_type
+{};
+
+template<typename _Type>
+constexpr bool is_tag_map_expression_v = is_tag_map_expression<_Type>::value;
+
+/**
+* Operands of element-wise arithmetic: tag maps, expressions of them and scalars applied to every tag.
+*/
+template<typename _Type>
+concept TagMapOperand = TagMap<std::remove_cvref_t<_Type>> || is_tag_map_expression_v<std::remove_cvref_t<_Type>>;
+
+template<typename _Type>
+concept ScalarOperand = std::is_arithmetic_v<std::remove_cvref_t<_Type>>;
+
+template<typename _Lhs, typename _Rhs>
+concept ElementwiseOperands = (TagMapOperand<_Lhs> && (TagMapOperand<_Rhs> || ScalarOperand<_Rhs>)) || (ScalarOperand<_Lhs> && TagMapOperand<_Rhs>);
+
+/**
+* How expressions hold their operands: tag map lvalues by reference, temporaries, expressions and scalars by value.
+*/
+template<typename _Operand>
+using expression_operand_t = std::conditional_t<TagMap<std::remove_cvref_t<_Operand>> && std::is_lvalue_reference_v<_Operand>,
+                                                std::remove_cvref_t<_Operand> const&,
+                                                std::remove_cvref_t<_Operand>>;
+
+template<char_tag _Tag, typename _Operand>
+constexpr bool operand_has_tag()
+{
+    using operand_type = std::remove_cvref_t<_Operand>;
+    if constexpr (TagMap<operand_type>)
+        return operand_type::template is_tag_valid<_Tag>();
+    else if constexpr (is_tag_map_expression_v<operand_type>)
+        return operand_type::template has_tag<_Tag>();
+    else
+        return true;
+}
+
+template<char_tag _Tag, typename _Operand>
+constexpr decltype(auto) evaluate_operand(_Operand const& operand)
+{
+    if constexpr (TagMap<_Operand>)
+        return operand.template get<_Tag>();
+    else if constexpr (is_tag_map_expression_v<_Operand>)
+        return operand.template evaluate<_Tag>();
+    else
+        return operand;
+}
+
+/**
+* Tag map whose tags the tags of an expression follow, the leftmost tag map operand.
+*/
+template<typename _Operand>
+struct tag_source : std::type_identity<void>
+{};
+
+template<TagMap _Operand>
+struct tag_source<_Operand> : std::type_identity<_Operand>
+{};
+
+template<typename _Operation, typename _Lhs, typename _Rhs>
+struct tag_source<tag_map_expression<_Operation, _Lhs, _Rhs>> : std::type_identity<typename tag_map_expression<_Operation, _Lhs, _Rhs>::tag_source_type>
+{};
+
+template<typename _Operand>
+using tag_source_t = typename tag_source<std::remove_cvref_t<_Operand>>::type;
+
+struct minimum
+{
+    template<typename _Lhs, typename _Rhs>
+    constexpr auto operator()(_Lhs const& lhs,
+                              _Rhs const& rhs) const
+    {
+        using result_type = std::common_type_t<_Lhs, _Rhs>;
+        return rhs < lhs ? result_type(rhs) : result_type(lhs);
+    }
+};
+
+struct maximum
+{
+    template<typename _Lhs, typename _Rhs>
+    constexpr auto operator()(_Lhs const& lhs,
+                              _Rhs const& rhs) const
+    {
+        using result_type = std::common_type_t<_Lhs, _Rhs>;
+        return lhs < rhs ? result_type(rhs) : result_type(lhs);
+    }
+};
+
+/**
+* Lazy element-wise operation on tag maps, matching values by tag instead of position.
+* An expression has the tags common to all of its tag map operands, in the order of the leftmost one.
+* Nothing is computed until the expression is converted to a tag map or assigned, then every tag is evaluated
+* through the whole expression at once, without temporary tag maps in between.
+*/
+template<typename _Operation, typename _Lhs, typename _Rhs>
+class tag_map_expression
+{
+public:
+
+    using tag_source_type = std::conditional_t<std::is_void_v<tag_source_t<_Lhs>>, tag_source_t<_Rhs>, tag_source_t<_Lhs>>;
+
+    constexpr tag_map_expression(_Lhs lhs,
+                                 _Rhs rhs)
+        : lhs(std::forward<_Lhs>(lhs))
+        , rhs(std::forward<_Rhs>(rhs))
+    {}
+
+    template<char_tag _Tag>
+    constexpr static bool has_tag()
+    {
+        return operand_has_tag<_Tag, _Lhs>() && operand_has_tag<_Tag, _Rhs>();
+    }
+
+    template<char_tag _Tag>
+        requires (has_tag<_Tag>())
+    constexpr auto evaluate() const
+    {
+        return _Operation()(evaluate_operand<_Tag>(lhs), evaluate_operand<_Tag>(rhs));
+    }
+
+    /**
+    * Whether the expression can produce _TagMap: it has every tag of it except the computed ones.
+    */
+    template<TagMap _TagMap>
+    constexpr static bool provides()
+    {
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return ((is_computed_value_v<typename std::tuple_element_t<_Indices, _TagMap>::value_type> || has_tag<_TagMap::template index_tag<_Indices>()>()) && ...);
+        }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+    }
+
+    /**
+    * Default constructible tag maps get the values assigned in place rather than passed to the constructor through
+    * references to temporaries. Flattened, so the whole expression is inlined into one pass however many tags there are.
+    */
+    template<TagMap _TagMap>
+        requires (provides<_TagMap>())
+    [[gnu::always_inline]] constexpr operator _TagMap() const
+    {
+        if constexpr (std::is_default_constructible_v<_TagMap>)
+        {
+            _TagMap result;
+            assign_all(result, std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+            return result;
+        }
+        else
+            return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+            {
+                return _TagMap(evaluate_or_computed<_TagMap, _Indices>()...);
+            }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+    }
+
+private:
+
+    template<TagMap _TagMap, size_t... _Indices>
+    [[gnu::always_inline, gnu::flatten]] constexpr void assign_all(_TagMap& result,
+                              std::index_sequence<_Indices...>) const
+    {
+        (assign_to<_TagMap::template index_tag<_Indices>()>(result), ...);
+    }
+
+    template<char_tag _Tag, TagMap _TagMap>
+    constexpr void assign_to(_TagMap& result) const
+    {
+        if constexpr (!is_computed_value_v<typename _TagMap::template get_tag_value_type_t<_Tag>>)
+            result.template get<_Tag>() = evaluate<_Tag>();
+    }
+
+    template<TagMap _TagMap, size_t _Index>
+    constexpr auto evaluate_or_computed() const
+    {
+        if constexpr (is_computed_value_v<typename std::tuple_element_t<_Index, _TagMap>::value_type>)
+            return computed;
+        else
+            return evaluate<_TagMap::template index_tag<_Index>()>();
+    }
+
+    _Lhs lhs;
+    _Rhs rhs;
+};
+
+template<typename _Operation, typename _Lhs, typename _Rhs>
+constexpr auto make_tag_map_expression(_Lhs&& lhs,
+                                       _Rhs&& rhs)
+{
+    return tag_map_expression<_Operation, expression_operand_t<_Lhs>, expression_operand_t<_Rhs>>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+template<typename _Lhs, typename _Rhs>
+    requires ElementwiseOperands<_Lhs, _Rhs>
+constexpr auto operator+(_Lhs&& lhs,
+                         _Rhs&& rhs)
+{
+    return make_tag_map_expression<std::plus<>>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+template<typename _Lhs, typename _Rhs>
+    requires ElementwiseOperands<_Lhs, _Rhs>
+constexpr auto operator-(_Lhs&& lhs,
+                         _Rhs&& rhs)
+{
+    return make_tag_map_expression<std::minus<>>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+template<typename _Lhs, typename _Rhs>
+    requires ElementwiseOperands<_Lhs, _Rhs>
+constexpr auto operator*(_Lhs&& lhs,
+                         _Rhs&& rhs)
+{
+    return make_tag_map_expression<std::multiplies<>>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+template<typename _Lhs, typename _Rhs>
+    requires ElementwiseOperands<_Lhs, _Rhs>
+constexpr auto operator/(_Lhs&& lhs,
+                         _Rhs&& rhs)
+{
+    return make_tag_map_expression<std::divides<>>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+template<typename _Lhs, typename _Rhs>
+    requires ElementwiseOperands<_Lhs, _Rhs>
+constexpr auto min(_Lhs&& lhs,
+                   _Rhs&& rhs)
+{
+    return make_tag_map_expression<minimum>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+template<typename _Lhs, typename _Rhs>
+    requires ElementwiseOperands<_Lhs, _Rhs>
+constexpr auto max(_Lhs&& lhs,
+                   _Rhs&& rhs)
+{
+    return make_tag_map_expression<maximum>(std::forward<_Lhs>(lhs), std::forward<_Rhs>(rhs));
+}
+
+/**
+* The tagged value of _Tag an expression evaluates to, as a tuple of zero or one elements, so tuple_cat drops the tags it lacks.
+*/
+template<typename _Expression, char_tag _Tag>
+struct expression_tagged_value : std::type_identity<std::tuple<>>
+{};
+
+template<typename _Expression, char_tag _Tag>
+    requires (_Expression::template has_tag<_Tag>())
+struct expression_tagged_value<_Expression, _Tag>
+    : std::type_identity<std::tuple<tagged_value<_Tag, decltype(std::declval<_Expression const&>().template evaluate<_Tag>())>>>
+{};
+
+template<typename _Expression, typename = std::make_index_sequence<std::tuple_size_v<tag_source_t<_Expression>>>>
+struct expression_result;
+
+template<typename _Expression, size_t... _Indices>
+struct expression_result<_Expression, std::index_sequence<_Indices...>>
+{
+    using tagged_tuple = decltype(std::tuple_cat(
+        std::declval<typename expression_tagged_value<_Expression, tag_source_t<_Expression>::template index_tag<_Indices>()>::type>()...));
+    using type = typename decltype([]<typename... _TaggedValues>(std::type_identity<std::tuple<_TaggedValues...>>)
+                                   {
+                                       return std::type_identity<tag_map<_TaggedValues...>>();
+                                   }(std::type_identity<tagged_tuple>()))::type;
+};
+
+template<typename _Expression>
+using expression_result_t = typename expression_result<_Expression>::type;
+
+/**
+* Tag map of the values of an expression, with the tags it has.
+*/
+template<typename _Operation, typename _Lhs, typename _Rhs>
+constexpr auto evaluate(tag_map_expression<_Operation, _Lhs, _Rhs> const& expression)
+{
+    return static_cast<expression_result_t<tag_map_expression<_Operation, _Lhs, _Rhs>>>(expression);
+}
+
+template<typename _Operation, char_tag _Tag, TagMap _TagMap, typename _Operand>
+constexpr void assign_elementwise_tag(_TagMap& target,
+                                      _Operand const& operand)
+{
+    if constexpr (!is_computed_value_v<typename _TagMap::template get_tag_value_type_t<_Tag>> && operand_has_tag<_Tag, _Operand>())
+        target.template get<_Tag>() = _Operation()(std::as_const(target).template get<_Tag>(), evaluate_operand<_Tag>(operand));
+}
+
+/**
+* Applies the operation to the tags target has in common with operand, in place and one tag at a time.
+*/
+template<typename _Operation, TagMap _TagMap, typename _Operand>
+[[gnu::flatten]] constexpr _TagMap& assign_elementwise(_TagMap& target,
+                                      _Operand const& operand)
+{
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        (assign_elementwise_tag<_Operation, _TagMap::template index_tag<_Indices>()>(target, operand), ...);
+    }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+    return target;
+}
+
+template<TagMap _TagMap, typename _Operand>
+    requires TagMapOperand<_Operand> || ScalarOperand<_Operand>
+constexpr _TagMap& operator+=(_TagMap& target,
+                              _Operand const& operand)
+{
+    return assign_elementwise<std::plus<>>(target, operand);
+}
+
+template<TagMap _TagMap, typename _Operand>
+    requires TagMapOperand<_Operand> || ScalarOperand<_Operand>
+constexpr _TagMap& operator-=(_TagMap& target,
+                              _Operand const& operand)
+{
+    return assign_elementwise<std::minus<>>(target, operand);
+}
+
+template<TagMap _TagMap, typename _Operand>
+    requires TagMapOperand<_Operand> || ScalarOperand<_Operand>
+constexpr _TagMap& operator*=(_TagMap& target,
+                              _Operand const& operand)
+{
+    return assign_elementwise<std::multiplies<>>(target, operand);
+}
+
+template<TagMap _TagMap, typename _Operand>
+    requires TagMapOperand<_Operand> || ScalarOperand<_Operand>
+constexpr _TagMap& operator/=(_TagMap& target,
+                              _Operand const& operand)
+{
+    return assign_elementwise<std::divides<>>(target, operand);
+}
+}
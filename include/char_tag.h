@@ -1,5 +1,9 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <concepts>
+#include <cstddef>
+#include <string_view>
 
 
 namespace ctmap
@@ -23,6 +27,14 @@ struct char_tag
     {
         return value;
     }
+
+    /**
+    * The tag without its terminating null character.
+    */
+    constexpr std::string_view view() const noexcept
+    {
+        return std::string_view(value, _Size - 1);
+    }
 };
 
 template<std::size_t _LhsSize, std::size_t _RhsSize>
@@ -31,21 +43,64 @@ constexpr bool operator==(char_tag<_LhsSize> const& lhs,
 {
     if constexpr (_LhsSize != _RhsSize)
         return false;
-    for (auto index = 0uz; index < _LhsSize; ++index)
-        if (lhs.value[index] != rhs.value[index])
-            return false;
-    return true;
+    else
+        return lhs.view() == rhs.view();
 }
 
-template<char_tag _Tag, char_tag... _Tags>
-constexpr bool is_unique_tag_list()
+/**
+* Flat compile time lookup table over a list of tags.
+* The tags are sorted once per list, lookups are binary searches instead of recursive instantiations.
+*/
+template<char_tag... _Tags>
+struct tag_table
 {
-    if constexpr (sizeof...(_Tags) > 0)
+    constexpr static std::size_t size = sizeof...(_Tags);
+    constexpr static std::size_t npos = size;
+
+    constexpr static std::array<std::string_view, size> names = { _Tags.view()... };
+
+private:
+
+    struct entry
+    {
+        std::string_view name;
+        std::size_t index;
+    };
+
+    constexpr static std::array<entry, size> sorted = []
     {
-        return ((_Tag != _Tags) && ...)
-            && is_unique_tag_list<_Tags...>();
+        std::array<entry, size> entries{};
+        for (auto index = 0uz; index < size; ++index)
+            entries[index] = { names[index], index };
+        std::ranges::sort(entries, {}, &entry::name);
+        return entries;
+    }();
+
+public:
+
+    constexpr static bool unique = std::ranges::adjacent_find(sorted, {}, &entry::name) == sorted.end();
+
+    /**
+    * Position of the tag in the list, or npos if it is not part of the list.
+    */
+    constexpr static std::size_t find(std::string_view name) noexcept
+    {
+        auto const it = std::ranges::lower_bound(sorted, name, {}, &entry::name);
+        if (it == sorted.end() || it->name != name)
+            return npos;
+        return it->index;
+    }
+
+    constexpr static bool contains(std::string_view name) noexcept
+    {
+        return find(name) != npos;
     }
-    return true;
+};
+
+template<char_tag... _Tags>
+constexpr bool is_unique_tag_list()
+{
+    return tag_table<_Tags...>::unique;
 }
 
 template<char_tag... _Tags>
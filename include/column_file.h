@@ -0,0 +1,458 @@
+#pragma once
+#include "ctmap.h"
+#include "serialization.h"
+#include "tag_map_vector.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "column_file.h needs POSIX mmap"
+#endif
+
+
+namespace ctmap
+{
+class column_file_error : public std::runtime_error
+{
+public:
+
+    using std::runtime_error::runtime_error;
+};
+
+/**
+* Layout of column files, all numbers in native byte order (which is part of the schema hash):
+* header: "ctmapcol", version, schema_hash_v, column count, per column: name length, name, value type hash, value size
+* then any number of row batches: row count, batch size in bytes, one column of values per tag.
+* The header, batches and columns start at multiples of column_file_alignment, so mapped columns can be used in place.
+*/
+constexpr std::string_view column_file_magic = "ctmapcol";
+constexpr std::uint64_t column_file_version = 1;
+constexpr size_t column_file_alignment = 64;
+constexpr size_t column_file_batch_header_size = column_file_alignment;
+
+constexpr size_t column_file_align(size_t size) noexcept
+{
+    return (size + column_file_alignment - 1) / column_file_alignment * column_file_alignment;
+}
+
+template<TagMap _TagMap>
+constexpr bool is_column_file_storable_v = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+{
+    using value_types = std::tuple<typename std::tuple_element_t<_Indices, _TagMap>::value_type...>;
+    return ((!std::is_reference_v<std::tuple_element_t<_Indices, value_types>> && BinaryTrivial<std::tuple_element_t<_Indices, value_types>>) && ...);
+}(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+
+template<TagMap _TagMap>
+    requires is_column_file_storable_v<_TagMap>
+std::vector<std::byte> make_column_file_header()
+{
+    std::vector<std::byte> header;
+    auto const append = [&header](void const* data, size_t size)
+    {
+        auto const offset = header.size();
+        header.resize(offset + size);
+        std::memcpy(header.data() + offset, data, size);
+    };
+    auto const append_number = [&append](std::uint64_t number)
+    {
+        append(&number, sizeof(number));
+    };
+
+    append(column_file_magic.data(), column_file_magic.size());
+    append_number(column_file_version);
+    append_number(schema_hash_v<_TagMap>);
+    append_number(std::tuple_size_v<_TagMap>);
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        ([&]
+         {
+             using tagged_value_type = std::tuple_element_t<_Indices, _TagMap>;
+             constexpr auto name = tagged_value_type::tag.view();
+             append_number(name.size());
+             append(name.data(), name.size());
+             header.resize((header.size() + 7) / 8 * 8);
+             append_number(type_hash<typename tagged_value_type::value_type>());
+             append_number(sizeof(typename tagged_value_type::value_type));
+         }(), ...);
+    }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+    header.resize(column_file_align(header.size()));
+    return header;
+}
+
+/**
+* Checks that bytes start with the header of a column file of _TagMap and returns the size of the header.
+*/
+template<TagMap _TagMap>
+    requires is_column_file_storable_v<_TagMap>
+size_t check_column_file_header(std::span<std::byte const> bytes)
+{
+    auto offset = 0uz;
+    auto const read = [&](void* data, size_t size)
+    {
+        if (bytes.size() - offset < size)
+            throw column_file_error("truncated column file header");
+        std::memcpy(data, bytes.data() + offset, size);
+        offset += size;
+    };
+    auto const read_number = [&read]
+    {
+        std::uint64_t number;
+        read(&number, sizeof(number));
+        return number;
+    };
+
+    char magic[column_file_magic.size()];
+    read(magic, sizeof(magic));
+    if (std::string_view(magic, sizeof(magic)) != column_file_magic)
+        throw column_file_error("not a column file");
+    if (read_number() != column_file_version)
+        throw column_file_error("unsupported column file version");
+    auto const schemaHash = read_number();
+    if (read_number() != std::tuple_size_v<_TagMap>)
+        throw column_file_error("column count mismatch");
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        ([&]
+         {
+             using tagged_value_type = std::tuple_element_t<_Indices, _TagMap>;
+             constexpr auto name = tagged_value_type::tag.view();
+             auto const nameSize = read_number();
+             if (bytes.size() - offset < nameSize)
+                 throw column_file_error("truncated column file header");
+             std::string const fileName(reinterpret_cast<char const*>(bytes.data() + offset), nameSize);
+             offset += nameSize;
+             if (fileName != name)
+                 throw column_file_error("column '" + fileName + "' where '" + std::string(name) + "' was expected");
+             offset = (offset + 7) / 8 * 8;
+             if (read_number() != type_hash<typename tagged_value_type::value_type>() || read_number() != sizeof(typename tagged_value_type::value_type))
+                 throw column_file_error("value type mismatch for column '" + fileName + "'");
+         }(), ...);
+    }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+    if (schemaHash != schema_hash_v<_TagMap>)
+        throw column_file_error("schema hash mismatch");
+    return column_file_align(offset);
+}
+
+/**
+* Appends row batches to a column file, creating the file with its header if it does not exist.
+*/
+template<TagMap _TagMap>
+    requires is_column_file_storable_v<_TagMap>
+class column_file_writer
+{
+public:
+
+    explicit column_file_writer(std::filesystem::path const& path)
+    {
+        auto const header = make_column_file_header<_TagMap>();
+        bool const exists = std::filesystem::exists(path) && std::filesystem::file_size(path) > 0;
+        if (exists)
+        {
+            std::vector<std::byte> existing(header.size());
+            std::ifstream in(path, std::ios::binary);
+            in.read(reinterpret_cast<char*>(existing.data()), std::streamsize(existing.size()));
+            existing.resize(size_t(in.gcount()));
+            check_column_file_header<_TagMap>(existing);
+        }
+
+        file.open(path, std::ios::binary | std::ios::app);
+        if (!file)
+            throw column_file_error("cannot open column file " + path.string());
+        if (!exists)
+            write(header.data(), header.size());
+    }
+
+    /**
+    * Writes the rows of tagMaps as one batch.
+    */
+    void append(tag_map_vector_from_tag_map_t<_TagMap> const& tagMaps)
+    {
+        write_batch(tagMaps.size(), [&]<char_tag _Tag>(std::byte* out)
+                    {
+                        auto const column = tagMaps.template column<_Tag>();
+                        if (!column.empty())
+                            std::memcpy(out, column.data(), column.size_bytes());
+                    });
+    }
+
+    void append(std::span<_TagMap const> tagMaps)
+    {
+        write_batch(tagMaps.size(), [&]<char_tag _Tag>(std::byte* out)
+                    {
+                        for (auto const& tagMap : tagMaps)
+                        {
+                            std::memcpy(out, std::addressof(tagMap.template get<_Tag>()), sizeof(tagMap.template get<_Tag>()));
+                            out += sizeof(tagMap.template get<_Tag>());
+                        }
+                    });
+    }
+
+    /**
+    * Writes everything appended so far to the file.
+    */
+    void flush()
+    {
+        if (!file.flush())
+            throw column_file_error("cannot write column file");
+    }
+
+private:
+
+    void write(void const* data,
+               size_t size)
+    {
+        if (!file.write(static_cast<char const*>(data), std::streamsize(size)))
+            throw column_file_error("cannot write column file");
+    }
+
+    template<typename _CopyColumn>
+    void write_batch(size_t rowCount,
+                     _CopyColumn&& copyColumn)
+    {
+        constexpr auto column_sizes = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return std::array<size_t, sizeof...(_Indices)>{ sizeof(typename std::tuple_element_t<_Indices, _TagMap>::value_type)... };
+        }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+
+        auto batchSize = column_file_batch_header_size;
+        for (auto size : column_sizes)
+            batchSize += column_file_align(size * rowCount);
+        buffer.assign(batchSize, std::byte{});
+        std::uint64_t const header[] = { rowCount, batchSize };
+        std::memcpy(buffer.data(), header, sizeof(header));
+
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            auto offset = column_file_batch_header_size;
+            ((copyColumn.template operator()<std::tuple_element_t<_Indices, _TagMap>::tag>(buffer.data() + offset),
+              offset += column_file_align(column_sizes[_Indices] * rowCount)), ...);
+        }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+        write(buffer.data(), buffer.size());
+    }
+
+    std::ofstream file;
+    std::vector<std::byte> buffer;
+};
+
+/**
+* Rows of one batch of a mapped column file, with one read-only span per tag.
+*/
+template<TagMap _TagMap>
+class column_file_batch
+{
+public:
+
+    using const_reference = typename tag_map_vector_from_tag_map_t<_TagMap>::const_reference;
+
+    column_file_batch(size_t rowCount,
+                      std::array<std::byte const*, std::tuple_size_v<_TagMap>> columns) noexcept
+        : rowCount(rowCount)
+        , columns(columns)
+    {}
+
+    size_t size() const noexcept
+    {
+        return rowCount;
+    }
+
+    bool empty() const noexcept
+    {
+        return rowCount == 0;
+    }
+
+    template<char_tag _Tag>
+    std::span<typename _TagMap::template get_tag_value_type_t<_Tag> const> column() const noexcept
+    {
+        using value_type = typename _TagMap::template get_tag_value_type_t<_Tag>;
+        return { reinterpret_cast<value_type const*>(columns[_TagMap::template tag_index<_Tag>()]), rowCount };
+    }
+
+    const_reference operator[](size_t index) const noexcept
+    {
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return const_reference(column<std::tuple_element_t<_Indices, _TagMap>::tag>()[index]...);
+        }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+    }
+
+private:
+
+    size_t rowCount;
+    std::array<std::byte const*, std::tuple_size_v<_TagMap>> columns;
+};
+
+/**
+* Read-only memory mapping of a column file of _TagMap.
+* Opening checks the header and walks the batch headers, the values themselves are only read when used.
+*/
+template<TagMap _TagMap>
+    requires is_column_file_storable_v<_TagMap>
+class column_file
+{
+public:
+
+    explicit column_file(std::filesystem::path const& path)
+    {
+        auto const descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (descriptor < 0)
+            throw column_file_error("cannot open column file " + path.string());
+        struct stat status;
+        if (::fstat(descriptor, &status) != 0 || status.st_size == 0)
+        {
+            ::close(descriptor);
+            throw column_file_error("cannot map column file " + path.string());
+        }
+        mappedSize = size_t(status.st_size);
+        auto* const mapping = ::mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, descriptor, 0);
+        ::close(descriptor);
+        if (mapping == MAP_FAILED)
+            throw column_file_error("cannot map column file " + path.string());
+        data = static_cast<std::byte const*>(mapping);
+
+        try
+        {
+            index_batches();
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+    }
+
+    column_file(column_file&& other) noexcept
+        : data(std::exchange(other.data, nullptr))
+        , mappedSize(std::exchange(other.mappedSize, 0))
+        , batches(std::move(other.batches))
+        , rowCount(std::exchange(other.rowCount, 0))
+    {}
+
+    column_file& operator=(column_file&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            data = std::exchange(other.data, nullptr);
+            mappedSize = std::exchange(other.mappedSize, 0);
+            batches = std::move(other.batches);
+            rowCount = std::exchange(other.rowCount, 0);
+        }
+        return *this;
+    }
+
+    ~column_file()
+    {
+        unmap();
+    }
+
+    /**
+    * Number of rows in all batches.
+    */
+    size_t size() const noexcept
+    {
+        return rowCount;
+    }
+
+    size_t batch_count() const noexcept
+    {
+        return batches.size();
+    }
+
+    column_file_batch<_TagMap> const& batch(size_t index) const noexcept
+    {
+        return batches[index];
+    }
+
+    auto begin() const noexcept
+    {
+        return batches.begin();
+    }
+
+    auto end() const noexcept
+    {
+        return batches.end();
+    }
+
+private:
+
+    void index_batches()
+    {
+        std::span const bytes(data, mappedSize);
+        auto offset = check_column_file_header<_TagMap>(bytes);
+        while (offset < bytes.size())
+        {
+            std::uint64_t header[2];
+            if (bytes.size() - offset < column_file_batch_header_size)
+                throw column_file_error("truncated column file batch");
+            std::memcpy(header, bytes.data() + offset, sizeof(header));
+            auto const [batchRowCount, batchSize] = header;
+            if (batchSize < column_file_batch_header_size || bytes.size() - offset < batchSize)
+                throw column_file_error("truncated column file batch");
+
+            std::array<std::byte const*, std::tuple_size_v<_TagMap>> columns;
+            auto columnOffset = offset + column_file_batch_header_size;
+            [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+            {
+                ([&]
+                 {
+                     using value_type = typename std::tuple_element_t<_Indices, _TagMap>::value_type;
+                     // checked before multiplying, a crafted row count could wrap around
+                     if (batchRowCount > batchSize / sizeof(value_type))
+                         throw column_file_error("corrupt column file batch");
+                     columns[_Indices] = bytes.data() + columnOffset;
+                     columnOffset += column_file_align(sizeof(value_type) * batchRowCount);
+                 }(), ...);
+            }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+            if (columnOffset - offset != batchSize)
+                throw column_file_error("corrupt column file batch");
+            // bool columns are used in place, so every byte has to be one of the two object representations of bool
+            [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+            {
+                ([&]
+                 {
+                     if constexpr (std::same_as<typename std::tuple_element_t<_Indices, _TagMap>::value_type, bool>)
+                         if (std::ranges::any_of(std::span(columns[_Indices], batchRowCount), [](std::byte byte)
+                                                 {
+                                                     return std::to_integer<unsigned int>(byte) > 1;
+                                                 }))
+                             throw column_file_error("invalid bool in column file");
+                 }(), ...);
+            }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+
+            batches.emplace_back(batchRowCount, columns);
+            rowCount += batchRowCount;
+            offset += batchSize;
+        }
+    }
+
+    void unmap() noexcept
+    {
+        if (data != nullptr)
+            ::munmap(const_cast<std::byte*>(data), mappedSize);
+        data = nullptr;
+    }
+
+    std::byte const* data = nullptr;
+    size_t mappedSize = 0;
+    std::vector<column_file_batch<_TagMap>> batches;
+    size_t rowCount = 0;
+};
+}
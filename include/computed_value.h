@@ -0,0 +1,203 @@
+#pragma once
+#include "char_tag.h"
+#include "tagged_value.h"
+
+#include <atomic>
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+
+
+namespace ctmap
+{
+/**
+* Result type of a function object with a single, non template call operator, e.g. a lambda with typed parameters.
+*/
+template<typename>
+struct call_result;
+
+template<typename _Class, typename _Result, typename... _Args>
+struct call_result<_Result (_Class::*)(_Args...)> : std::type_identity<std::remove_cvref_t<_Result>>
+{};
+
+template<typename _Class, typename _Result, typename... _Args>
+struct call_result<_Result (_Class::*)(_Args...) const> : std::type_identity<std::remove_cvref_t<_Result>>
+{};
+
+template<typename _Class, typename _Result, typename... _Args>
+struct call_result<_Result (_Class::*)(_Args...) noexcept> : std::type_identity<std::remove_cvref_t<_Result>>
+{};
+
+template<typename _Class, typename _Result, typename... _Args>
+struct call_result<_Result (_Class::*)(_Args...) const noexcept> : std::type_identity<std::remove_cvref_t<_Result>>
+{};
+
+template<typename _Function>
+using call_result_t = typename call_result<decltype(&_Function::operator())>::type;
+
+/**
+* Placeholder passed to tag map constructors for computed tagged values, which are never given a value.
+*/
+struct computed_t
+{
+    explicit computed_t() = default;
+};
+
+constexpr inline computed_t computed{};
+
+/**
+* Value derived from the values of _DependencyTags by _Function, computed on first access and cached.
+* Tag maps invalidate the cache whenever one of the dependencies is accessed mutably.
+* Invalidation only marks the cache stale and recomputing assigns in place, so references to the result stay valid.
+* Like other const access, reading from several threads at once is safe: one of them fills the cache, the others wait for it.
+* Copies start out stale. Two computed values always compare equal, the values they are computed from decide.
+*/
+template<typename _Function, char_tag... _DependencyTags>
+class computed_value
+{
+    static_assert(std::is_default_constructible_v<_Function>, "computed values need a default constructible function");
+
+    enum class cache_state : std::uint8_t
+    {
+        stale,
+        computing,
+        valid
+    };
+
+public:
+
+    using function_type = _Function;
+    using result_type = call_result_t<_Function>;
+
+    constexpr computed_value() noexcept = default;
+
+    constexpr explicit computed_value(computed_t) noexcept
+    {}
+
+    constexpr computed_value(computed_value const&) noexcept
+    {}
+
+    computed_value& operator=(computed_value const&) noexcept
+    {
+        invalidate();
+        return *this;
+    }
+
+    template<char_tag _Tag>
+    constexpr static bool depends_on()
+    {
+        return ((_Tag == _DependencyTags) || ...);
+    }
+
+    template<typename _TagMap>
+    result_type const& get(_TagMap const& tagMap) const
+    {
+        if (state.load(std::memory_order_acquire) != cache_state::valid) [[unlikely]]
+            fill(tagMap);
+        return *cache;
+    }
+
+    bool is_cached() const noexcept
+    {
+        return state.load(std::memory_order_acquire) == cache_state::valid;
+    }
+
+    /**
+    * Marks the cache stale, only called through mutable access to the tag map, which no other thread reads meanwhile.
+    */
+    void invalidate() const noexcept
+    {
+        state.store(cache_state::stale, std::memory_order_relaxed);
+    }
+
+    friend constexpr bool operator==(computed_value const&, computed_value const&) noexcept
+    {
+        return true;
+    }
+
+    friend constexpr std::strong_ordering operator<=>(computed_value const&, computed_value const&) noexcept
+    {
+        return std::strong_ordering::equal;
+    }
+
+private:
+
+    /**
+    * Computes the value unless another thread already does, in which case it waits for that one.
+    */
+    template<typename _TagMap>
+    [[gnu::noinline]] void fill(_TagMap const& tagMap) const
+    {
+        for (auto current = state.load(std::memory_order_acquire); current != cache_state::valid;)
+        {
+            if (current == cache_state::stale && state.compare_exchange_weak(current, cache_state::computing, std::memory_order_acquire))
+            {
+                compute(tagMap);
+                return;
+            }
+            if (current == cache_state::computing)
+            {
+                state.wait(current, std::memory_order_acquire);
+                current = state.load(std::memory_order_acquire);
+            }
+        }
+    }
+
+    template<typename _TagMap>
+    void compute(_TagMap const& tagMap) const
+    {
+        try
+        {
+            if (cache)
+                *cache = std::invoke(_Function(), tagMap.template get<_DependencyTags>()...);
+            else
+                cache.emplace(std::invoke(_Function(), tagMap.template get<_DependencyTags>()...));
+        }
+        catch (...)
+        {
+            state.store(cache_state::stale, std::memory_order_release);
+            state.notify_all();
+            throw;
+        }
+        state.store(cache_state::valid, std::memory_order_release);
+        state.notify_all();
+    }
+
+    mutable std::optional<result_type> cache;
+    mutable std::atomic<cache_state> state = cache_state::stale;
+};
+
+template<typename>
+struct is_computed_value : std::false_type
+{};
+
+template<typename _Function, char_tag... _DependencyTags>
+struct is_computed_value<computed_value<_Function, _DependencyTags...>> : std::true_type
+{};
+
+template<typename _Type>
+constexpr bool is_computed_value_v = is_computed_value<_Type>::value;
+
+/**
+* What get returns for a value type: the result of computed values, the value type itself otherwise.
+*/
+template<typename _ValueType>
+struct tag_value_result : std::type_identity<_ValueType>
+{};
+
+template<typename _Function, char_tag... _DependencyTags>
+struct tag_value_result<computed_value<_Function, _DependencyTags...>> : std::type_identity<typename computed_value<_Function, _DependencyTags...>::result_type>
+{};
+
+template<typename _ValueType>
+using tag_value_result_t = typename tag_value_result<_ValueType>::type;
+
+/**
+* Tagged value computed from the tags _DependencyTags of the same tag map, e.g.
+* computed_tag<"key", decltype([](std::string const& name, int id) { return name + std::to_string(id); }), "name", "id">.
+*/
+template<char_tag _Tag, typename _Function, char_tag... _DependencyTags>
+using computed_tag = tagged_value<_Tag, computed_value<_Function, _DependencyTags...>>;
+}
@@ -0,0 +1,269 @@
+#pragma once
+#include "ctmap.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+/**
+* Storage of one value of a concurrent_tag_map, read and written in two steps: raw loads and stores are done
+* inside the seqlock windows, the conversions from and to values outside of them.
+* Non trivially copyable values are immutable and shared, a store publishes a new one.
+*/
+template<typename _ValueType>
+class concurrent_cell
+{
+public:
+
+    using raw_type = std::shared_ptr<_ValueType const>;
+
+    constexpr static bool single_load = true;
+
+    static raw_type to_raw(_ValueType value)
+    {
+        return std::make_shared<_ValueType const>(std::move(value));
+    }
+
+    static _ValueType from_raw(raw_type const& raw)
+    {
+        return *raw;
+    }
+
+    raw_type load() const noexcept
+    {
+        return value.load(std::memory_order_acquire);
+    }
+
+    void store(raw_type raw) noexcept
+    {
+        value.store(std::move(raw), std::memory_order_release);
+    }
+
+private:
+
+    std::atomic<raw_type> value;
+};
+
+/**
+* Trivially copyable values are copied in and out of relaxed atomic words, so racing with a writer is no data race,
+* and values of a single word are read without the seqlock at all.
+*/
+template<typename _ValueType>
+    requires std::is_trivially_copyable_v<_ValueType>
+class concurrent_cell<_ValueType>
+{
+    constexpr static size_t word_count = (sizeof(_ValueType) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+public:
+
+    using raw_type = std::array<std::uint64_t, word_count>;
+
+    constexpr static bool single_load = word_count == 1;
+
+    static raw_type to_raw(_ValueType const& value) noexcept
+    {
+        raw_type raw{};
+        std::memcpy(raw.data(), &value, sizeof(_ValueType));
+        return raw;
+    }
+
+    static _ValueType from_raw(raw_type const& raw) noexcept
+    {
+        std::array<std::byte, sizeof(_ValueType)> bytes;
+        std::memcpy(bytes.data(), raw.data(), sizeof(_ValueType));
+        return std::bit_cast<_ValueType>(bytes);
+    }
+
+    raw_type load() const noexcept
+    {
+        raw_type raw;
+        for (auto index = 0uz; index < word_count; ++index)
+            raw[index] = words[index].load(word_count == 1 ? std::memory_order_acquire : std::memory_order_relaxed);
+        return raw;
+    }
+
+    void store(raw_type const& raw) noexcept
+    {
+        for (auto index = 0uz; index < word_count; ++index)
+            words[index].store(raw[index], word_count == 1 ? std::memory_order_release : std::memory_order_relaxed);
+    }
+
+private:
+
+    std::array<std::atomic<std::uint64_t>, word_count> words{};
+};
+
+/**
+* Tag map shared between threads, for many readers and few writers.
+* Readers never lock: snapshot copies a consistent set of tagged values under a seqlock and retries if a write overlapped.
+* Writers are serialized by a mutex and keep the seqlock odd only while publishing already prepared values.
+*/
+template<TaggedValue... _TaggedValues>
+class concurrent_tag_map
+{
+    static_assert(!(std::is_reference_v<typename _TaggedValues::value_type> || ...), "concurrent_tag_map cannot store references");
+
+public:
+
+    using values_type = tag_map<_TaggedValues...>;
+
+    template<char_tag _Tag>
+    using get_tagged_value_type_t = typename values_type::template get_tagged_value_type_t<_Tag>;
+    template<char_tag _Tag>
+    using get_tag_value_type_t = typename values_type::template get_tag_value_type_t<_Tag>;
+
+    /**
+    * Constructs the values like tag_map does.
+    */
+    template<typename... _Args>
+        requires std::constructible_from<values_type, _Args...>
+    explicit concurrent_tag_map(_Args&&... args)
+    {
+        values_type values(std::forward<_Args>(args)...);
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            (std::get<_Indices>(cells).store(cell_type<_Indices>::to_raw(std::move(values.template get<_Indices>().value))), ...);
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+    }
+
+    concurrent_tag_map(concurrent_tag_map const&) = delete;
+    concurrent_tag_map& operator=(concurrent_tag_map const&) = delete;
+
+    template<char_tag _Tag>
+    constexpr static bool is_tag_valid()
+    {
+        return values_type::template is_tag_valid<_Tag>();
+    }
+
+    template<char_tag _Tag>
+    constexpr static size_t tag_index()
+    {
+        return values_type::template tag_index<_Tag>();
+    }
+
+    /**
+    * Copy of the value of _Tag. Single word and shared values are loaded atomically without the seqlock.
+    */
+    template<char_tag _Tag>
+        requires (is_tag_valid<_Tag>())
+    get_tag_value_type_t<_Tag> load() const
+    {
+        constexpr auto index = tag_index<_Tag>();
+        if constexpr (cell_type<index>::single_load)
+            return cell_type<index>::from_raw(std::get<index>(cells).load());
+        else
+            return std::move(snapshot<_Tag>().template get<_Tag>());
+    }
+
+    /**
+    * Consistent copy of the given tagged values, as a tag_map of them in the given order.
+    */
+    template<char_tag... _Tags>
+        requires (is_tag_valid<_Tags>() && ...)
+    tag_map<get_tagged_value_type_t<_Tags>...> snapshot() const
+    {
+        for (;;)
+        {
+            auto const before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+                continue;
+            auto const raws = load_raws<_Tags...>();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+                return from_raws<_Tags...>(raws);
+        }
+    }
+
+    template<all_tags_t>
+    values_type snapshot() const
+    {
+        return snapshot<_TaggedValues::tag...>();
+    }
+
+    /**
+    * Replaces the value of _Tag. The value is converted before locking.
+    */
+    template<char_tag _Tag, typename _ValueType>
+        requires (is_tag_valid<_Tag>() && std::constructible_from<get_tag_value_type_t<_Tag>, _ValueType>)
+    void store(_ValueType&& value)
+    {
+        constexpr auto index = tag_index<_Tag>();
+        auto raw = cell_type<index>::to_raw(get_tag_value_type_t<_Tag>(std::forward<_ValueType>(value)));
+        std::scoped_lock lock(writeMutex);
+        write([&]
+              {
+                  std::get<index>(cells).store(std::move(raw));
+              });
+    }
+
+    /**
+    * Calls function with references to copies of the current values of the given tags, like tag_map::apply,
+    * and publishes the modified copies together. Other writers wait until update returns, readers never do.
+    */
+    template<char_tag... _Tags, typename _Function>
+        requires (is_tag_valid<_Tags>() && ...)
+    void update(_Function&& function)
+    {
+        std::scoped_lock lock(writeMutex);
+        auto values = from_raws<_Tags...>(load_raws<_Tags...>());
+        values.template apply<all_tags>(std::forward<_Function>(function));
+        auto raws = std::tuple(cell_type<tag_index<_Tags>()>::to_raw(std::move(values.template get<_Tags>()))...);
+        write([&]
+              {
+                  [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                  {
+                      (std::get<tag_index<_Tags>()>(cells).store(std::move(std::get<_Indices>(raws))), ...);
+                  }(std::make_index_sequence<sizeof...(_Tags)>());
+              });
+    }
+
+private:
+
+    template<size_t _Index>
+    using cell_type = concurrent_cell<typename std::tuple_element_t<_Index, values_type>::value_type>;
+
+    template<char_tag... _Tags>
+    auto load_raws() const
+    {
+        return std::tuple(std::get<tag_index<_Tags>()>(cells).load()...);
+    }
+
+    template<char_tag... _Tags, typename _Raws>
+    static tag_map<get_tagged_value_type_t<_Tags>...> from_raws(_Raws const& raws)
+    {
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return tag_map<get_tagged_value_type_t<_Tags>...>(cell_type<tag_index<_Tags>()>::from_raw(std::get<_Indices>(raws))...);
+        }(std::make_index_sequence<sizeof...(_Tags)>());
+    }
+
+    /**
+    * Runs the stores of publish with the sequence odd, the caller holds writeMutex.
+    */
+    template<typename _Function>
+    void write(_Function&& publish)
+    {
+        auto const before = sequence.load(std::memory_order_relaxed);
+        sequence.store(before + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        publish();
+        sequence.store(before + 2, std::memory_order_release);
+    }
+
+    // on its own cache line, readers polling it do not share one with the values of single loads
+    alignas(64) std::atomic<std::uint64_t> sequence = 0;
+    alignas(64) std::tuple<concurrent_cell<typename _TaggedValues::value_type>...> cells;
+    std::mutex writeMutex;
+};
+}
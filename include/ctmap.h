@@ -1,4 +1,5 @@
 #pragma once
 #include "char_tag.h"
+#include "computed_value.h"
 #include "tag_map.h"
 #include "tagged_value.h"
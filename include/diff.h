@@ -0,0 +1,107 @@
+#pragma once
+#include "ctmap.h"
+#include "sparse_tag_map.h"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+template<TagMap _TagMap, typename = stored_index_sequence_t<_TagMap>>
+struct tag_map_patch;
+
+template<TagMap _TagMap>
+using tag_map_patch_t = typename tag_map_patch<_TagMap>::type;
+
+/**
+* What a patch stores for a value: a nested patch for tag map values, the new value otherwise.
+*/
+template<typename _ValueType>
+struct patch_value : std::type_identity<_ValueType>
+{};
+
+template<TagMap _ValueType>
+struct patch_value<_ValueType> : tag_map_patch<_ValueType>
+{};
+
+template<typename _ValueType>
+using patch_value_t = typename patch_value<_ValueType>::type;
+
+/**
+* Changes between two tag maps of the same schema, a sparse tag map holding the new values of the changed tags only.
+* Computed tags are not part of it, patching their dependencies invalidates them.
+*/
+template<TagMap _TagMap, size_t... _Indices>
+struct tag_map_patch<_TagMap, std::index_sequence<_Indices...>>
+    : std::type_identity<sparse_tag_map<tagged_value<std::tuple_element_t<_Indices, _TagMap>::tag, patch_value_t<typename std::tuple_element_t<_Indices, _TagMap>::value_type>>...>>
+{};
+
+/**
+* Whether any stored value differs, stopping at the first one that does. The yes/no form of diff.
+*/
+template<TagMap _TagMap>
+constexpr bool differs(_TagMap const& from,
+                       _TagMap const& to)
+{
+    return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        return (!(from.template get<_Indices>().value == to.template get<_Indices>().value) || ...);
+    }(stored_index_sequence_t<_TagMap>());
+}
+
+/**
+* Patch turning from into to. Tag map values are diffed recursively, so only their changed values are stored.
+*/
+template<TagMap _TagMap>
+constexpr tag_map_patch_t<_TagMap> diff(_TagMap const& from,
+                                        _TagMap const& to)
+{
+    tag_map_patch_t<_TagMap> result;
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        ([&]
+         {
+             constexpr auto tag = std::tuple_element_t<_Indices, _TagMap>::tag;
+             auto const& fromValue = from.template get<_Indices>().value;
+             auto const& toValue = to.template get<_Indices>().value;
+             if constexpr (TagMap<std::remove_cvref_t<decltype(toValue)>>)
+             {
+                 if (auto nested = diff(fromValue, toValue); nested.count() != 0)
+                     result.template emplace<tag>(std::move(nested));
+             }
+             else if (!(fromValue == toValue))
+                 result.template emplace<tag>(toValue);
+         }(), ...);
+    }(stored_index_sequence_t<_TagMap>());
+    return result;
+}
+
+/**
+* Applies a patch created by diff to target, moving the new values out of tagMapPatch if it is an rvalue.
+*/
+template<TagMap _TagMap, typename _Patch>
+    requires std::same_as<std::remove_cvref_t<_Patch>, tag_map_patch_t<_TagMap>>
+constexpr void patch(_TagMap& target,
+                     _Patch&& tagMapPatch)
+{
+    tagMapPatch.for_each_present([&target](auto& taggedValue)
+                                 {
+                                     constexpr auto tag = std::remove_cvref_t<decltype(taggedValue)>::tag;
+                                     auto& targetValue = target.template get<tag>();
+                                     if constexpr (TagMap<std::remove_cvref_t<decltype(targetValue)>>)
+                                     {
+                                         if constexpr (std::is_lvalue_reference_v<_Patch>)
+                                             patch(targetValue, taggedValue.value);
+                                         else
+                                             patch(targetValue, std::move(taggedValue.value));
+                                     }
+                                     else if constexpr (std::is_lvalue_reference_v<_Patch>)
+                                         targetValue = taggedValue.value;
+                                     else
+                                         targetValue = std::move(taggedValue.value);
+                                 });
+}
+}
@@ -1,14 +1,279 @@
 #pragma once
 #include "ctmap.h"
+#include "sparse_tag_map.h"
 
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
 #include <format>
-#include <iomanip>
-#include <sstream>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 
+namespace ctmap
+{
+template<typename _ValueType>
+concept StdFormattable = std::is_default_constructible_v<std::formatter<_ValueType, char>>;
+
+/**
+* Length of a string after quoting it the way std::quoted does.
+*/
+constexpr size_t quoted_size(std::string_view string) noexcept
+{
+    return 2 + string.size() + std::ranges::count_if(string, [](char character)
+                                                     {
+                                                         return character == '"' || character == '\\';
+                                                     });
+}
+
+template<typename _OutputIt>
+constexpr _OutputIt write_escaped(char character,
+                                  _OutputIt out)
+{
+    if (character == '"' || character == '\\')
+        *out++ = '\\';
+    *out++ = character;
+    return out;
+}
+
+template<typename _OutputIt>
+constexpr _OutputIt write_escaped(std::string_view string,
+                                  _OutputIt out)
+{
+    for (auto character : string)
+        out = write_escaped(character, out);
+    return out;
+}
+
+/**
+* Stream buffer escaping everything inserted into it straight into an output iterator.
+* Used for values that only support operator<<, so they need neither a std::stringstream nor std::quoted.
+*/
+template<typename _OutputIt>
+class escaping_streambuf : public std::streambuf
+{
+public:
+
+    explicit escaping_streambuf(_OutputIt out)
+        : out(std::move(out))
+    {}
+
+    _OutputIt get() &&
+    {
+        return std::move(out);
+    }
+
+protected:
+
+    int_type overflow(int_type character) override
+    {
+        if (!traits_type::eq_int_type(character, traits_type::eof()))
+            out = write_escaped(traits_type::to_char_type(character), std::move(out));
+        return traits_type::not_eof(character);
+    }
+
+    std::streamsize xsputn(char const* string,
+                           std::streamsize count) override
+    {
+        out = write_escaped(std::string_view(string, static_cast<size_t>(count)), std::move(out));
+        return count;
+    }
+
+private:
+
+    _OutputIt out;
+};
+
+/**
+* Output iterator escaping every character written through it into another output iterator.
+*/
+template<typename _OutputIt>
+class escaping_iterator
+{
+public:
+
+    using difference_type = std::ptrdiff_t;
+
+    explicit escaping_iterator(_OutputIt out)
+        : out(std::move(out))
+    {}
+
+    escaping_iterator& operator=(char character)
+    {
+        out = write_escaped(character, std::move(out));
+        return *this;
+    }
+
+    escaping_iterator& operator*() noexcept
+    {
+        return *this;
+    }
+
+    escaping_iterator& operator++() noexcept
+    {
+        return *this;
+    }
+
+    escaping_iterator& operator++(int) noexcept
+    {
+        return *this;
+    }
+
+    _OutputIt get() &&
+    {
+        return std::move(out);
+    }
+
+private:
+
+    _OutputIt out;
+};
+
+/**
+* A value together with the std::formatter that parsed its spec, so it can be formatted again into another output iterator.
+*/
+template<typename _ValueType>
+struct formatted_value
+{
+    std::formatter<_ValueType, char> const& formatter;
+    _ValueType const& value;
+};
+
+/**
+* The quoted tags of a tag map followed by ": ", laid out in a single compile time string pool.
+*/
+template<TagMap _TagMap>
+struct format_keys;
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct format_keys<basic_tag_map<_Layout, _TaggedValues...>>
+{
+private:
+
+    constexpr static auto pool = []
+    {
+        std::array<char, ((quoted_size(_TaggedValues::tag.view()) + 2) + ... + 0)> result{};
+        [[maybe_unused]] auto out = result.begin();
+        ((*out++ = '"', out = write_escaped(_TaggedValues::tag.view(), out), *out++ = '"', *out++ = ':', *out++ = ' '), ...);
+        return result;
+    }();
+
+public:
+
+    constexpr static std::array<std::string_view, sizeof...(_TaggedValues)> keys = []
+    {
+        std::array<std::string_view, sizeof...(_TaggedValues)> result{};
+        [[maybe_unused]] auto offset = 0uz;
+        [[maybe_unused]] auto index = 0uz;
+        ((result[index++] = std::string_view(pool.data() + offset, quoted_size(_TaggedValues::tag.view()) + 2),
+          offset += quoted_size(_TaggedValues::tag.view()) + 2), ...);
+        return result;
+    }();
+};
+}
+
+template<typename _ValueType>
+struct std::formatter<ctmap::formatted_value<_ValueType>, char>
+{
+    template<typename _Context>
+    constexpr auto parse(_Context& context)
+    {
+        return context.begin();
+    }
+
+    template<class _Context>
+    auto format(ctmap::formatted_value<_ValueType> const& formattedValue,
+                _Context& context) const
+    {
+        return formattedValue.formatter.format(formattedValue.value, context);
+    }
+};
+
+/**
+* Formats tag maps as { "tag": "value", ... }.
+* Format spec: [m]{|tag:spec}, where m selects one line per tagged value and every |tag:spec
+* forwards spec to the std::formatter of that tag's value, e.g. std::format("{:m|price:.2f}", tagMap).
+* Values are written through their own std::formatter where there is one and through operator<< otherwise,
+* directly into the output without intermediate strings.
+*/
 template<ctmap::TagMap _TagMap>
 struct std::formatter<_TagMap, char>
 {
+private:
+
+    // computed values are formatted as their result
+    template<size_t _Index>
+    using value_type_t = ctmap::tag_value_result_t<std::remove_cvref_t<typename std::tuple_element_t<_Index, _TagMap>::value_type>>;
+
+    struct stream_formatter
+    {};
+
+    template<typename _ValueType>
+    using value_formatter_t = std::conditional_t<ctmap::StdFormattable<_ValueType>, std::formatter<_ValueType, char>, stream_formatter>;
+
+    using value_formatters = decltype([]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                                      {
+                                          return std::tuple<value_formatter_t<value_type_t<_Indices>>...>();
+                                      }(std::make_index_sequence<std::tuple_size_v<_TagMap>>()));
+
+    template<size_t _Index>
+    constexpr void parse_value_spec(std::string_view spec)
+    {
+        using value_type = value_type_t<_Index>;
+        if constexpr (ctmap::StdFormattable<value_type>)
+        {
+            std::basic_format_parse_context<char> valueContext(spec);
+            if (std::get<_Index>(formatters).parse(valueContext) != valueContext.end())
+                throw std::format_error("Invalid format spec for tag_map value.");
+            hasSpec[_Index] = true;
+        }
+        else
+            throw std::format_error("Format spec for tag_map value without std::formatter.");
+    }
+
+    template<size_t _Index, class _Context>
+    void format_value(_TagMap const& tagMap,
+                      _Context& context) const
+    {
+        using value_type = value_type_t<_Index>;
+        auto const& value = tagMap.template get<_TagMap::template index_tag<_Index>()>();
+        if constexpr (std::is_convertible_v<value_type const&, std::string_view>)
+        {
+            if (!hasSpec[_Index])
+            {
+                context.advance_to(ctmap::write_escaped(std::string_view(value), context.out()));
+                return;
+            }
+        }
+        if constexpr (std::is_arithmetic_v<value_type> && !std::same_as<value_type, char>)
+        {
+            // numbers and bools only contain characters to escape if a spec asks for them as fill
+            if (!hasSpec[_Index])
+            {
+                context.advance_to(std::get<_Index>(formatters).format(value, context));
+                return;
+            }
+        }
+        if constexpr (ctmap::StdFormattable<value_type>)
+        {
+            auto out = std::format_to(ctmap::escaping_iterator(context.out()), "{}", ctmap::formatted_value<value_type>{ std::get<_Index>(formatters), value });
+            context.advance_to(std::move(out).get());
+        }
+        else
+        {
+            ctmap::escaping_streambuf buffer(context.out());
+            std::ostream(&buffer) << value;
+            context.advance_to(std::move(buffer).get());
+        }
+    }
+
+public:
+
     bool multiline = false;
 
     template<typename _Context>
@@ -22,6 +287,27 @@ struct std::formatter<_TagMap, char>
             multiline = true;
             ++it;
         }
+        while (it != context.end() && *it == '|')
+        {
+            auto const tagBegin = ++it;
+            it = std::find(it, context.end(), ':');
+            if (it == context.end())
+                throw std::format_error("Missing ':' after tag in tag_map format spec.");
+            std::string_view const tag(tagBegin, it);
+            auto const specBegin = ++it;
+            it = std::find_if(it, context.end(), [](char character)
+                              {
+                                  return character == '|' || character == '}';
+                              });
+            std::string_view const spec(specBegin, it);
+
+            bool const valid = [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+            {
+                return ((tag == std::tuple_element_t<_Indices, _TagMap>::tag.view() && (parse_value_spec<_Indices>(spec), true)) || ...);
+            }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+            if (!valid)
+                throw std::format_error("Unknown tag in tag_map format spec.");
+        }
         if (it != context.end() && *it != '}')
             throw std::format_error("Invalid format args for tag_map.");
         return it;
@@ -31,23 +317,57 @@ struct std::formatter<_TagMap, char>
     auto format(_TagMap const& tagMap,
                 _Context& context) const
     {
-        std::ostringstream out;
-        char const* delim = multiline ? ",\n    " : ", ";
-        out << '{' << (multiline ? "\n    " : " ");
-        bool skipDelim = true;
-        auto const print = [&](auto const& taggedType)
-        {
-            if (!skipDelim)
-                out << delim;
-            skipDelim = false;
-            out << std::quoted(taggedType.tag.value) << ": " << std::quoted((std::stringstream() << taggedType.value).str());
-        };
-        ctmap::apply([&](auto const&... taggedTypes)
-                     {
-                         ((print(taggedTypes)), ...);
-                     },
-                     tagMap);
-        out << (multiline ? '\n' : ' ') << '}';
-        return std::ranges::copy(std::move(out).str(), context.out()).out;
+        constexpr static std::array<bool, std::tuple_size_v<_TagMap>> all_present = []
+        {
+            std::array<bool, std::tuple_size_v<_TagMap>> result{};
+            result.fill(true);
+            return result;
+        }();
+        return format_present(tagMap, all_present, context);
+    }
+
+protected:
+
+    /**
+    * Formats the first _Count tagged values of tagMap whose entry in present is set, leaving out the others.
+    */
+    template<size_t _Count, class _Context>
+    auto format_present(_TagMap const& tagMap,
+                        std::array<bool, _Count> const& present,
+                        _Context& context) const
+    {
+        using namespace std::string_view_literals;
+        auto const delim = multiline ? ",\n    "sv : ", "sv;
+        context.advance_to(std::ranges::copy(multiline ? "{\n    "sv : "{ "sv, context.out()).out);
+        [[maybe_unused]] auto first = true;
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            ((present[_Indices] ? (context.advance_to(std::ranges::copy(std::exchange(first, false) ? ""sv : delim, context.out()).out),
+                                   context.advance_to(std::ranges::copy(ctmap::format_keys<_TagMap>::keys[_Indices], context.out()).out),
+                                   context.advance_to(std::ranges::copy("\""sv, context.out()).out),
+                                   format_value<_Indices>(tagMap, context),
+                                   context.advance_to(std::ranges::copy("\""sv, context.out()).out))
+                                : void()), ...);
+        }(std::make_index_sequence<_Count>());
+        return std::ranges::copy(multiline ? "\n}"sv : " }"sv, context.out()).out;
+    }
+
+private:
+
+    value_formatters formatters;
+    std::array<bool, std::tuple_size_v<_TagMap>> hasSpec{};
+};
+
+/**
+* Formats sparse tag maps like tag maps, leaving out absent tagged values.
+*/
+template<ctmap::TaggedValue... _TaggedValues>
+struct std::formatter<ctmap::sparse_tag_map<_TaggedValues...>, char> : std::formatter<typename ctmap::sparse_tag_map<_TaggedValues...>::values_type, char>
+{
+    template<class _Context>
+    auto format(ctmap::sparse_tag_map<_TaggedValues...> const& sparseTagMap,
+                _Context& context) const
+    {
+        return this->format_present(sparseTagMap.all_values(), sparseTagMap.present(), context);
     }
 };
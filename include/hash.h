@@ -0,0 +1,216 @@
+#pragma once
+#include "ctmap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+template<typename _ValueType>
+concept StdHashable = requires(_ValueType const& value) { { std::hash<_ValueType>()(value) } -> std::convertible_to<size_t>; };
+
+/**
+* splitmix64 finalizer, spreads every input bit over the whole result.
+* std::hash of integers is the identity in common standard libraries, so combined hashes are mixed once more.
+*/
+constexpr std::uint64_t hash_mix(std::uint64_t hash) noexcept
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    return hash ^ (hash >> 31);
+}
+
+constexpr std::uint64_t hash_combine(std::uint64_t seed,
+                                     std::uint64_t hash) noexcept
+{
+    return hash_mix(seed + 0x9e3779b97f4a7c15ull + hash);
+}
+
+/**
+* Combined hash of the values of the given tags, in the order of the tags.
+* Any tag map holding these tags with the same value types hashes to the same value, whatever else it holds.
+*/
+template<char_tag... _Tags, typename _TagMap>
+constexpr size_t hash_tags(_TagMap const& tagMap)
+{
+    std::uint64_t result = sizeof...(_Tags);
+    ((result = hash_combine(result, std::hash<std::remove_cvref_t<decltype(tagMap.template get<_Tags>())>>()(tagMap.template get<_Tags>()))), ...);
+    return size_t(result);
+}
+
+/**
+* Hash of the stored values of a tag map. Computed values follow from them and compare equal anyway, so they are left out.
+*/
+template<TagMap _TagMap, typename = stored_index_sequence_t<_TagMap>>
+struct tag_map_hasher;
+
+template<TagMap _TagMap, size_t... _Indices>
+struct tag_map_hasher<_TagMap, std::index_sequence<_Indices...>>
+{
+    constexpr size_t operator()(_TagMap const& tagMap) const
+    {
+        return hash_tags<_TagMap::template index_tag<_Indices>()...>(tagMap);
+    }
+};
+
+/**
+* Open addressing hash index mapping the values of some key tags to the rows of a collection of tag maps.
+* The index stores only row numbers and key hashes, the keys themselves are read from the collection,
+* which every call is given and which has to be the one the rows were inserted for.
+* Keys are unique, lookups take any tag map holding the key tags, e.g. one made of just those tags.
+*/
+template<char_tag... _KeyTags>
+class tag_index
+{
+    static_assert(sizeof...(_KeyTags) > 0, "tag_index needs at least one key tag");
+
+    struct slot
+    {
+        size_t hash;
+        size_t row;
+    };
+
+public:
+
+    constexpr static size_t npos = size_t(-1);
+
+    tag_index() = default;
+
+    /**
+    * Index over all rows of records.
+    */
+    template<std::ranges::random_access_range _Records>
+    explicit tag_index(_Records const& records)
+    {
+        auto const count = size_t(std::ranges::distance(records));
+        reserve(count);
+        for (auto row = 0uz; row < count; ++row)
+            insert(records, row);
+    }
+
+    size_t size() const noexcept
+    {
+        return count;
+    }
+
+    bool empty() const noexcept
+    {
+        return count == 0;
+    }
+
+    void clear() noexcept
+    {
+        std::ranges::fill(slots, slot{ .hash = 0, .row = npos });
+        count = 0;
+    }
+
+    /**
+    * Makes room for count keys without growing.
+    */
+    void reserve(size_t count)
+    {
+        auto const capacity = std::bit_ceil(std::max((count * 8 + 6) / 7, 8uz));
+        if (capacity > slots.size())
+            rehash(capacity);
+    }
+
+    /**
+    * Indexes row of records. Returns false and leaves the index unchanged if another row has the same key.
+    */
+    template<std::ranges::random_access_range _Records>
+    bool insert(_Records const& records,
+                size_t row)
+    {
+        reserve(count + 1);
+        auto const first = std::ranges::begin(records);
+        auto const hash = hash_tags<_KeyTags...>(first[row]);
+        for (auto position = hash & mask();; position = (position + 1) & mask())
+        {
+            auto& current = slots[position];
+            if (current.row == npos)
+            {
+                current = slot{ .hash = hash, .row = row };
+                ++count;
+                return true;
+            }
+            if (current.hash == hash && equal_tags<_KeyTags...>(first[current.row], first[row]))
+                return false;
+        }
+    }
+
+    /**
+    * Row whose key tags equal those of key, or std::nullopt.
+    */
+    template<std::ranges::random_access_range _Records, typename _Key>
+    std::optional<size_t> find(_Records const& records,
+                               _Key const& key) const
+    {
+        if (count == 0)
+            return std::nullopt;
+        auto const first = std::ranges::begin(records);
+        auto const hash = hash_tags<_KeyTags...>(key);
+        for (auto position = hash & mask();; position = (position + 1) & mask())
+        {
+            auto const& current = slots[position];
+            if (current.row == npos)
+                return std::nullopt;
+            if (current.hash == hash && equal_tags<_KeyTags...>(first[current.row], key))
+                return current.row;
+        }
+    }
+
+    template<std::ranges::random_access_range _Records, typename _Key>
+    bool contains(_Records const& records,
+                  _Key const& key) const
+    {
+        return find(records, key).has_value();
+    }
+
+private:
+
+    size_t mask() const noexcept
+    {
+        return slots.size() - 1;
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<slot> previous(capacity, slot{ .hash = 0, .row = npos });
+        previous.swap(slots);
+        for (auto const& current : previous)
+            if (current.row != npos)
+            {
+                auto position = current.hash & mask();
+                while (slots[position].row != npos)
+                    position = (position + 1) & mask();
+                slots[position] = current;
+            }
+    }
+
+    std::vector<slot> slots;
+    size_t count = 0;
+};
+}
+
+/**
+* Hashes tag maps whose stored values all have a std::hash, combining the hashes of the values in declared order.
+*/
+template<ctmap::TagMap _TagMap>
+    requires ([]<size_t... _Indices>(std::index_sequence<_Indices...>)
+              {
+                  return (ctmap::StdHashable<std::remove_cvref_t<typename std::tuple_element_t<_Indices, _TagMap>::value_type>> && ...);
+              }(ctmap::stored_index_sequence_t<_TagMap>()))
+struct std::hash<_TagMap> : ctmap::tag_map_hasher<_TagMap>
+{};
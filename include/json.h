@@ -0,0 +1,546 @@
+#pragma once
+#include "ctmap.h"
+#include "value_traits.h"
+#include "visit.h"
+
+#include <array>
+#include <bitset>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+class json_error : public std::runtime_error
+{
+public:
+
+    using std::runtime_error::runtime_error;
+};
+
+template<typename _Type>
+concept JsonString = std::convertible_to<_Type const&, std::string_view>;
+
+template<typename _Type>
+concept JsonArray = std::ranges::input_range<_Type const> && !JsonString<_Type> && !TagMap<_Type>;
+
+/**
+* Writes a string as a quoted JSON string, escaping quotes, backslashes and control characters.
+*/
+template<typename _OutputIt>
+constexpr _OutputIt write_json_string(std::string_view string,
+                                      _OutputIt out)
+{
+    using namespace std::string_view_literals;
+    auto const write = [&out](std::string_view escape)
+    {
+        out = std::ranges::copy(escape, std::move(out)).out;
+    };
+
+    constexpr char hexDigits[] = "0123456789abcdef";
+    *out++ = '"';
+    for (unsigned char character : string)
+    {
+        switch (character)
+        {
+        case '"': write("\\\""sv); break;
+        case '\\': write("\\\\"sv); break;
+        case '\b': write("\\b"sv); break;
+        case '\f': write("\\f"sv); break;
+        case '\n': write("\\n"sv); break;
+        case '\r': write("\\r"sv); break;
+        case '\t': write("\\t"sv); break;
+        default:
+            if (character < 0x20)
+            {
+                write("\\u00"sv);
+                *out++ = hexDigits[character >> 4];
+                *out++ = hexDigits[character & 0xf];
+            }
+            else
+                *out++ = static_cast<char>(character);
+        }
+    }
+    *out++ = '"';
+    return out;
+}
+
+/**
+* A tag as an object key: quoted, escaped at compile time and followed by ':'.
+*/
+template<char_tag _Tag>
+struct json_key
+{
+private:
+
+    // every character escapes to at most 6 ("\u00XX")
+    constexpr static auto escaped = []
+    {
+        std::array<char, 6 * _Tag.view().size() + 3> result{};
+        auto const last = write_json_string(_Tag.view(), result.begin());
+        *last = ':';
+        return std::pair(result, size_t(last - result.begin()) + 1);
+    }();
+
+public:
+
+    constexpr static std::string_view value = std::string_view(escaped.first.data(), escaped.second);
+};
+
+template<char_tag _Tag>
+constexpr std::string_view json_key_v = json_key<_Tag>::value;
+
+/**
+* Writes a value as JSON.
+* Tag maps become objects keyed by their tags, optionals become null or their value,
+* strings are escaped, other ranges become arrays.
+*/
+template<typename _ValueType, typename _OutputIt>
+constexpr _OutputIt write_json(_ValueType const& value,
+                               _OutputIt out)
+{
+    using namespace std::string_view_literals;
+    auto const write = [&out](std::string_view string)
+    {
+        out = std::ranges::copy(string, std::move(out)).out;
+    };
+
+    if constexpr (TagMap<_ValueType>)
+    {
+        // computed values are left out, reading the object back computes them again
+        *out++ = '{';
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            [[maybe_unused]] auto first = true;
+            ((write(std::exchange(first, false) ? ""sv : ","sv),
+              write(json_key_v<std::tuple_element_t<_Indices, _ValueType>::tag>),
+              out = write_json(value.template get<_Indices>().value, std::move(out))), ...);
+        }(stored_index_sequence_t<_ValueType>());
+        *out++ = '}';
+    }
+    else if constexpr (is_optional_v<_ValueType>)
+    {
+        if (value)
+            out = write_json(*value, std::move(out));
+        else
+            write("null"sv);
+    }
+    else if constexpr (std::same_as<_ValueType, bool>)
+        write(value ? "true"sv : "false"sv);
+    else if constexpr (std::is_arithmetic_v<_ValueType>)
+    {
+        if constexpr (std::floating_point<_ValueType>)
+        {
+            if (value != value || value - value != value - value)
+            {
+                write("null"sv);
+                return out;
+            }
+        }
+        char buffer[64];
+        auto const result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        write(std::string_view(buffer, result.ptr));
+    }
+    else if constexpr (JsonString<_ValueType>)
+        out = write_json_string(std::string_view(value), std::move(out));
+    else if constexpr (JsonArray<_ValueType>)
+    {
+        *out++ = '[';
+        auto first = true;
+        for (auto const& element : value)
+        {
+            if (!std::exchange(first, false))
+                *out++ = ',';
+            out = write_json(element, std::move(out));
+        }
+        *out++ = ']';
+    }
+    else
+        static_assert(sizeof(_ValueType) == 0, "type cannot be written as JSON");
+    return out;
+}
+
+template<TagMap _TagMap, typename _OutputIt>
+constexpr _OutputIt to_json(_TagMap const& tagMap,
+                            _OutputIt out)
+{
+    return write_json(tagMap, std::move(out));
+}
+
+template<TagMap _TagMap>
+std::string to_json(_TagMap const& tagMap)
+{
+    std::string result;
+    to_json(tagMap, std::back_inserter(result));
+    return result;
+}
+
+/**
+* Recursive descent JSON reader filling values of known types in place.
+* Object keys are dispatched through the perfect hash of the tag map's tags, unknown keys are skipped
+* without being parsed. std::string_view values point into the input and require unescaped strings.
+*/
+class json_reader
+{
+public:
+
+    constexpr explicit json_reader(std::string_view input) noexcept
+        : begin(input.data())
+        , it(input.data())
+        , end(input.data() + input.size())
+    {}
+
+    template<typename _ValueType>
+    void read(_ValueType& value)
+    {
+        skip_whitespace();
+        if constexpr (TagMap<_ValueType>)
+            read_object(value);
+        else if constexpr (is_optional_v<_ValueType>)
+        {
+            if (consume_literal("null"))
+                value.reset();
+            else
+                read(value.emplace());
+        }
+        else if constexpr (std::same_as<_ValueType, bool>)
+        {
+            if (consume_literal("true"))
+                value = true;
+            else if (consume_literal("false"))
+                value = false;
+            else
+                fail("expected boolean");
+        }
+        else if constexpr (std::is_arithmetic_v<_ValueType>)
+        {
+            auto const result = std::from_chars(it, end, value);
+            if (result.ec != std::errc())
+                fail("expected number");
+            it = result.ptr;
+            if constexpr (std::integral<_ValueType>)
+            {
+                if (it != end && (*it == '.' || *it == 'e' || *it == 'E'))
+                    fail("expected integer");
+            }
+        }
+        else if constexpr (std::same_as<_ValueType, std::string_view>)
+        {
+            auto const [string, escaped] = read_raw_string();
+            if (escaped)
+                fail("escaped string cannot be read into std::string_view");
+            value = string;
+        }
+        else if constexpr (requires { value.assign(std::string_view()); } && JsonString<_ValueType>)
+        {
+            auto const [string, escaped] = read_raw_string();
+            if (escaped)
+            {
+                value.clear();
+                unescape(string, value);
+            }
+            else
+                value.assign(string);
+        }
+        else if constexpr (requires { std::tuple_size<_ValueType>::value; } && JsonArray<_ValueType>)
+        {
+            expect('[');
+            auto first = true;
+            for (auto& element : value)
+            {
+                if (!std::exchange(first, false))
+                    expect(',');
+                read(element);
+            }
+            expect(']');
+        }
+        else if constexpr (JsonArray<_ValueType> && requires { value.clear(); value.insert(value.end(), std::declval<typename _ValueType::value_type>()); })
+        {
+            value.clear();
+            expect('[');
+            skip_whitespace();
+            if (it != end && *it == ']')
+            {
+                ++it;
+                return;
+            }
+            do
+            {
+                typename _ValueType::value_type element{};
+                read(element);
+                value.insert(value.end(), std::move(element));
+            }
+            while (consume(','));
+            expect(']');
+        }
+        else
+            static_assert(sizeof(_ValueType) == 0, "type cannot be read from JSON");
+    }
+
+    void finish()
+    {
+        skip_whitespace();
+        if (it != end)
+            fail("trailing characters");
+    }
+
+private:
+
+    [[noreturn]] void fail(char const* message) const
+    {
+        throw json_error(std::string(message) + " at offset " + std::to_string(it - begin));
+    }
+
+    void skip_whitespace() noexcept
+    {
+        while (it != end && (*it == ' ' || *it == '\n' || *it == '\r' || *it == '\t'))
+            ++it;
+    }
+
+    bool consume(char character) noexcept
+    {
+        skip_whitespace();
+        if (it == end || *it != character)
+            return false;
+        ++it;
+        return true;
+    }
+
+    void expect(char character)
+    {
+        if (!consume(character))
+            fail("unexpected character");
+    }
+
+    bool consume_literal(std::string_view literal) noexcept
+    {
+        if (std::string_view(it, end).starts_with(literal))
+        {
+            it += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    /**
+    * The characters between the quotes, still escaped, and whether there are any escapes.
+    */
+    std::pair<std::string_view, bool> read_raw_string()
+    {
+        if (it == end || *it != '"')
+            fail("expected string");
+        auto const first = ++it;
+        auto escaped = false;
+        for (; it != end && *it != '"'; ++it)
+        {
+            if (*it == '\\')
+            {
+                escaped = true;
+                if (++it == end)
+                    break;
+            }
+        }
+        if (it == end)
+            fail("unterminated string");
+        return { std::string_view(first, it++), escaped };
+    }
+
+    template<typename _String>
+    void unescape(std::string_view string,
+                  _String& value)
+    {
+        auto const hex = [&](std::size_t& index)
+        {
+            std::uint32_t codePoint = 0;
+            if (index + 4 >= string.size()
+                || std::from_chars(string.data() + index + 1, string.data() + index + 5, codePoint, 16).ptr != string.data() + index + 5)
+                fail("invalid unicode escape");
+            index += 4;
+            return codePoint;
+        };
+        for (auto index = 0uz; index < string.size(); ++index)
+        {
+            if (string[index] != '\\')
+            {
+                value.push_back(string[index]);
+                continue;
+            }
+            switch (string[++index])
+            {
+            case 'b': value.push_back('\b'); break;
+            case 'f': value.push_back('\f'); break;
+            case 'n': value.push_back('\n'); break;
+            case 'r': value.push_back('\r'); break;
+            case 't': value.push_back('\t'); break;
+            case 'u':
+            {
+                auto codePoint = hex(index);
+                if (codePoint >= 0xd800 && codePoint < 0xdc00 && string.substr(index + 1, 2) == "\\u")
+                {
+                    index += 2;
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (hex(index) - 0xdc00);
+                }
+                if (codePoint < 0x80)
+                    value.push_back(static_cast<char>(codePoint));
+                else if (codePoint < 0x800)
+                {
+                    value.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+                    value.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+                }
+                else if (codePoint < 0x10000)
+                {
+                    value.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+                    value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+                    value.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+                }
+                else
+                {
+                    value.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+                    value.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+                    value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+                    value.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+                }
+                break;
+            }
+            default: value.push_back(string[index]);
+            }
+        }
+    }
+
+    /**
+    * Skips any value by matching brackets, without validating or decoding it.
+    */
+    void skip_value()
+    {
+        skip_whitespace();
+        if (it != end && (*it == ',' || *it == '}' || *it == ']'))
+            fail("expected value");
+        auto depth = 0uz;
+        do
+        {
+            if (it == end)
+                fail("unexpected end of input");
+            switch (*it)
+            {
+            case '"':
+                read_raw_string();
+                continue;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (depth == 0)
+                    return;
+                --depth;
+                break;
+            case ',':
+                if (depth == 0)
+                    return;
+                break;
+            default:
+                break;
+            }
+            ++it;
+        }
+        while (depth > 0 || (it != end && *it != ',' && *it != '}' && *it != ']'));
+    }
+
+    template<typename _TagMap>
+    void read_object(_TagMap& tagMap)
+    {
+        using value_reader = void(*)(json_reader&, _TagMap&);
+        using hash_table = tag_map_hash_table_t<_TagMap>;
+        constexpr auto size = std::tuple_size_v<_TagMap>;
+
+        constexpr auto readers = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return std::array<value_reader, size>{
+                [](json_reader& reader, _TagMap& tagMap)
+                {
+                    if constexpr (is_computed_value_v<typename std::tuple_element_t<_Indices, _TagMap>::value_type>)
+                        reader.skip_value();
+                    else
+                        reader.read(tagMap.template get<_TagMap::template index_tag<_Indices>()>());
+                }...
+            };
+        }(std::make_index_sequence<size>());
+        constexpr auto required = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return std::array<bool, size>{
+                !is_optional_v<std::remove_cvref_t<typename std::tuple_element_t<_Indices, _TagMap>::value_type>>
+                    && !is_computed_value_v<typename std::tuple_element_t<_Indices, _TagMap>::value_type>...
+            };
+        }(std::make_index_sequence<size>());
+
+        std::bitset<size> seen;
+        expect('{');
+        if (!consume('}'))
+        {
+            std::string unescapedKey;
+            do
+            {
+                skip_whitespace();
+                auto [key, escaped] = read_raw_string();
+                if (escaped)
+                {
+                    unescapedKey.clear();
+                    unescape(key, unescapedKey);
+                    key = unescapedKey;
+                }
+                expect(':');
+                auto const index = hash_table::find(key);
+                if (index == hash_table::npos)
+                    skip_value();
+                else
+                {
+                    readers[index](*this, tagMap);
+                    seen[index] = true;
+                }
+            }
+            while (consume(','));
+            expect('}');
+        }
+        for (auto index = 0uz; index < size; ++index)
+            if (required[index] && !seen[index])
+                fail("missing key");
+    }
+
+    char const* begin;
+    char const* it;
+    char const* end;
+};
+
+/**
+* Reads a JSON object into an existing tag map, e.g. one created by tie_tag_map.
+*/
+template<typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+void from_json(std::string_view json,
+               _TagMap&& tagMap)
+{
+    json_reader reader(json);
+    reader.read(tagMap);
+    reader.finish();
+}
+
+template<TagMap _TagMap>
+    requires std::default_initializable<_TagMap>
+_TagMap from_json(std::string_view json)
+{
+    _TagMap tagMap;
+    from_json(json, tagMap);
+    return tagMap;
+}
+}
@@ -0,0 +1,500 @@
+#pragma once
+#include "formatter.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+class log_error : public std::runtime_error
+{
+public:
+
+    using std::runtime_error::runtime_error;
+};
+
+/**
+* Values logged by copying their characters into the record.
+*/
+template<typename _Type>
+concept LogString = std::convertible_to<_Type const&, std::string_view>;
+
+/**
+* Values logged by copying their bytes into the record. Only types without indirection qualify, the consumer
+* formats records later and must not follow pointers, spans or iterators the logging thread may have invalidated.
+*/
+template<typename _Type>
+concept LogTrivial = !LogString<_Type> && (std::is_arithmetic_v<_Type> || std::is_enum_v<_Type>);
+
+template<typename _Type>
+concept Loggable = LogString<_Type> || LogTrivial<_Type>;
+
+/**
+* Type a logged value is decoded to by the consumer, strings are viewed in place in the ring buffer.
+*/
+template<typename _ValueType>
+using log_decoded_t = std::conditional_t<LogString<_ValueType>, std::string_view, _ValueType>;
+
+struct log_record_header
+{
+    // schema 0 marks the unused rest of the ring buffer before it wraps around
+    std::uint32_t schema;
+    std::uint32_t size;
+};
+
+// records are padded to whole headers, so a header always fits in front of the end of the buffer
+constexpr inline size_t log_record_alignment = sizeof(log_record_header);
+
+/**
+* Single producer, single consumer ring buffer of contiguous records.
+* Positions only ever grow and are masked into the buffer, a record that does not fit before the end
+* is preceded by a padding record filling it.
+*/
+class log_ring
+{
+public:
+
+    explicit log_ring(size_t capacity)
+        : mask(std::bit_ceil(std::max(capacity, 2 * sizeof(log_record_header))) - 1)
+        , buffer(std::make_unique<std::byte[]>(mask + 1))
+    {}
+
+    size_t capacity() const noexcept
+    {
+        return mask + 1;
+    }
+
+    /**
+    * Contiguous space for a record of size bytes, nullptr while the consumer has not freed enough of it.
+    */
+    std::byte* try_reserve(size_t size) noexcept
+    {
+        auto const offset = head & mask;
+        auto const padding = offset + size > capacity() ? capacity() - offset : 0;
+        if (head + padding + size - cachedTail > capacity())
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (head + padding + size - cachedTail > capacity())
+                return nullptr;
+        }
+        if (padding)
+        {
+            log_record_header const header{ 0, std::uint32_t(padding) };
+            std::memcpy(buffer.get() + offset, &header, sizeof(header));
+            head += padding;
+        }
+        return buffer.get() + (head & mask);
+    }
+
+    void commit(size_t size) noexcept
+    {
+        head += size;
+        publishedHead.store(head, std::memory_order_release);
+    }
+
+    /**
+    * Calls function(header, payload) for every published record, returns the position after them to release.
+    */
+    template<typename _Function>
+    size_t read(_Function&& function) const
+    {
+        auto const end = publishedHead.load(std::memory_order_acquire);
+        auto position = tail.load(std::memory_order_relaxed);
+        while (position != end)
+        {
+            log_record_header header;
+            std::memcpy(&header, buffer.get() + (position & mask), sizeof(header));
+            if (header.schema)
+                function(header, buffer.get() + (position & mask) + sizeof(header));
+            position += header.size;
+        }
+        return position;
+    }
+
+    /**
+    * Frees the records before position for the producer.
+    */
+    void release(size_t position) noexcept
+    {
+        tail.store(position, std::memory_order_release);
+    }
+
+    /**
+    * Whether the consumer has freed every record published so far.
+    */
+    bool drained() const noexcept
+    {
+        return tail.load(std::memory_order_acquire) == publishedHead.load(std::memory_order_acquire);
+    }
+
+    /**
+    * Marks the ring as no longer written to, its thread exited.
+    */
+    void retire() noexcept
+    {
+        retired.store(true, std::memory_order_release);
+    }
+
+    /**
+    * Whether the producer is gone, everything published before is visible to a read that follows.
+    */
+    bool is_retired() const noexcept
+    {
+        return retired.load(std::memory_order_acquire);
+    }
+
+    /**
+    * Marks the ring as no longer read, its logger was destroyed.
+    */
+    void close() noexcept
+    {
+        closed.store(true, std::memory_order_relaxed);
+    }
+
+    bool is_closed() const noexcept
+    {
+        return closed.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    size_t const mask;
+    std::unique_ptr<std::byte[]> buffer;
+    // producer side, head and cachedTail are only touched by the producer
+    alignas(64) size_t head = 0;
+    size_t cachedTail = 0;
+    std::atomic<size_t> publishedHead = 0;
+    // consumer side
+    alignas(64) std::atomic<size_t> tail = 0;
+    std::atomic<bool> retired = false;
+    std::atomic<bool> closed = false;
+};
+
+/**
+* Ring buffers of the calling thread, one per logger it logs to, retired when the thread exits.
+*/
+struct log_thread_rings
+{
+    log_thread_rings() = default;
+    log_thread_rings(log_thread_rings const&) = delete;
+    log_thread_rings& operator=(log_thread_rings const&) = delete;
+
+    ~log_thread_rings()
+    {
+        for (auto const& [loggerId, ring] : rings)
+            ring->retire();
+    }
+
+    std::vector<std::pair<std::uint64_t, std::shared_ptr<log_ring>>> rings;
+};
+
+using log_format_function = void (*)(std::byte const* payload, std::string& out);
+
+constexpr inline size_t max_log_schemas = 1024;
+
+inline std::array<std::atomic<log_format_function>, max_log_schemas> logSchemas{};
+inline std::atomic<std::uint32_t> logSchemaCount = 0;
+
+template<size_t _Index, typename _TagMap>
+using log_value_type_t = std::remove_cvref_t<typename std::tuple_element_t<_Index, _TagMap>::value_type>;
+
+/**
+* Tag map the consumer decodes a record of _TagMap into, with the same tags.
+*/
+template<TagMap _TagMap, typename = std::make_index_sequence<std::tuple_size_v<_TagMap>>>
+struct log_decoded_tag_map;
+
+template<TagMap _TagMap, size_t... _Indices>
+struct log_decoded_tag_map<_TagMap, std::index_sequence<_Indices...>>
+    : std::type_identity<tag_map<tagged_value<_TagMap::template index_tag<_Indices>(), log_decoded_t<log_value_type_t<_Indices, _TagMap>>>...>>
+{};
+
+template<TagMap _TagMap>
+using log_decoded_tag_map_t = typename log_decoded_tag_map<_TagMap>::type;
+
+template<typename _ValueType>
+constexpr size_t log_encoded_size(_ValueType const& value) noexcept
+{
+    if constexpr (LogString<_ValueType>)
+        return sizeof(std::uint32_t) + std::string_view(value).size();
+    else
+        return sizeof(_ValueType);
+}
+
+template<typename _ValueType>
+std::byte* log_encode(_ValueType const& value,
+                      std::byte* out) noexcept
+{
+    if constexpr (LogString<_ValueType>)
+    {
+        std::string_view const string(value);
+        auto const size = std::uint32_t(string.size());
+        std::memcpy(out, &size, sizeof(size));
+        std::memcpy(out + sizeof(size), string.data(), string.size());
+        return out + sizeof(size) + string.size();
+    }
+    else
+    {
+        std::memcpy(out, std::addressof(value), sizeof(_ValueType));
+        return out + sizeof(_ValueType);
+    }
+}
+
+template<typename _ValueType>
+log_decoded_t<_ValueType> log_decode(std::byte const*& in) noexcept
+{
+    if constexpr (LogString<_ValueType>)
+    {
+        std::uint32_t size;
+        std::memcpy(&size, in, sizeof(size));
+        std::string_view const string(reinterpret_cast<char const*>(in + sizeof(size)), size);
+        in += sizeof(size) + size;
+        return string;
+    }
+    else
+    {
+        std::array<std::byte, sizeof(_ValueType)> bytes;
+        std::memcpy(bytes.data(), in, sizeof(_ValueType));
+        in += sizeof(_ValueType);
+        return std::bit_cast<_ValueType>(bytes);
+    }
+}
+
+/**
+* Formats a record of _TagMap with the std::formatter of tag maps, as the tag map would have been formatted when logged.
+*/
+template<TagMap _TagMap>
+void format_log_record(std::byte const* payload,
+                       std::string& out)
+{
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        // braced initialization decodes the values in order
+        log_decoded_tag_map_t<_TagMap> const decoded{ log_decode<log_value_type_t<_Indices, _TagMap>>(payload)... };
+        std::format_to(std::back_inserter(out), "{}", decoded);
+    }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+}
+
+/**
+* Small id of the schema of _TagMap that records carry instead of their tags and types, registered on first use.
+*/
+template<TagMap _TagMap>
+std::uint32_t log_schema_id()
+{
+    static std::uint32_t const id = []
+    {
+        auto const index = logSchemaCount.fetch_add(1, std::memory_order_relaxed);
+        if (index >= max_log_schemas)
+            throw log_error("too many logged tag map types");
+        logSchemas[index].store(&format_log_record<_TagMap>, std::memory_order_release);
+        return std::uint32_t(index + 1);
+    }();
+    return id;
+}
+
+/**
+* Structured logging of tag maps that keeps formatting off the logging threads.
+* log copies the raw values with a schema id into a ring buffer of the calling thread, without locks or allocations
+* once the thread has its ring buffer. A consumer thread formats the records with the std::formatter of tag maps
+* and passes them to the sink in batches of lines. Records of one thread keep their order, records of different threads
+* are interleaved as they are drained.
+*/
+class tag_map_logger
+{
+public:
+
+    using sink_type = std::function<void(std::string_view)>;
+
+    explicit tag_map_logger(sink_type sink,
+                            size_t ringCapacity = 1 << 20)
+        : sink(std::move(sink))
+        , ringCapacity(ringCapacity)
+        , consumer([this](std::stop_token stopToken)
+                   {
+                       consume(stopToken);
+                   })
+    {}
+
+    tag_map_logger(tag_map_logger const&) = delete;
+    tag_map_logger& operator=(tag_map_logger const&) = delete;
+
+    /**
+    * Stops the consumer once everything logged so far is written.
+    * Threads still alive drop their rings of this logger the next time they log to a new one.
+    */
+    ~tag_map_logger()
+    {
+        consumer.request_stop();
+        consumer.join();
+        for (auto const& ring : rings)
+            ring->close();
+    }
+
+    /**
+    * Records the values of tagMap, waiting for the consumer if the ring buffer of this thread is full.
+    */
+    template<TagMap _TagMap>
+    void log(_TagMap const& tagMap)
+    {
+        static_assert([]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                      {
+                          return (Loggable<log_value_type_t<_Indices, _TagMap>> && ...);
+                      }(std::make_index_sequence<std::tuple_size_v<_TagMap>>()),
+                      "logged values need to be arithmetic, enums or strings");
+        auto const schema = log_schema_id<_TagMap>();
+        auto const payloadSize = tagMap.template apply<all_tags>([](auto const&... values)
+                                                                 {
+                                                                     return (log_encoded_size(values) + ... + 0uz);
+                                                                 });
+        auto const size = (sizeof(log_record_header) + payloadSize + log_record_alignment - 1) & ~(log_record_alignment - 1);
+        auto& ring = thread_ring();
+        if (size > ring.capacity() / 2)
+            throw log_error("log record larger than half the ring buffer");
+        auto* out = ring.try_reserve(size);
+        while (!out)
+        {
+            std::this_thread::yield();
+            out = ring.try_reserve(size);
+        }
+        log_record_header const header{ schema, std::uint32_t(size) };
+        std::memcpy(out, &header, sizeof(header));
+        tagMap.template apply<all_tags>([&](auto const&... values)
+                                        {
+                                            auto* valueOut = out + sizeof(header);
+                                            ((valueOut = log_encode(values, valueOut)), ...);
+                                        });
+        ring.commit(size);
+    }
+
+    /**
+    * Waits until everything logged so far by any thread is written to the sink.
+    */
+    void flush()
+    {
+        for (;;)
+        {
+            {
+                std::scoped_lock lock(ringsMutex);
+                if (std::ranges::all_of(rings, [](auto const& ring) { return ring->drained(); }))
+                    return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+private:
+
+    log_ring& thread_ring()
+    {
+        thread_local log_thread_rings threadRings;
+        for (auto const& [loggerId, ring] : threadRings.rings)
+            if (loggerId == id)
+                return *ring;
+        // ids are never reused, rings of destroyed loggers are only dropped here so the list stays short
+        std::erase_if(threadRings.rings, [](auto const& entry)
+                      {
+                          return entry.second->is_closed();
+                      });
+        auto ring = std::make_shared<log_ring>(ringCapacity);
+        {
+            std::scoped_lock lock(ringsMutex);
+            rings.push_back(ring);
+            ringsVersion.fetch_add(1, std::memory_order_release);
+        }
+        threadRings.rings.emplace_back(id, ring);
+        return *ring;
+    }
+
+    /**
+    * Drains the rings round robin, sleeping briefly once none of them had records. Sleeps are short so
+    * ring buffers do not fill up. Only the consumer removes rings, those of exited threads once they are drained,
+    * so its snapshot can be read without the lock.
+    */
+    void consume(std::stop_token stopToken)
+    {
+        std::string lines;
+        std::vector<log_ring*> snapshot;
+        auto snapshotVersion = 0uz;
+        for (;;)
+        {
+            if (snapshotVersion != ringsVersion.load(std::memory_order_acquire))
+            {
+                std::scoped_lock lock(ringsMutex);
+                snapshot.clear();
+                for (auto const& ring : rings)
+                    snapshot.push_back(ring.get());
+                snapshotVersion = ringsVersion.load(std::memory_order_relaxed);
+            }
+            auto const stopping = stopToken.stop_requested();
+            auto consumed = 0uz;
+            auto retired = false;
+            for (auto* ring : snapshot)
+            {
+                // checked before reading, a retired ring is empty once this read is released
+                retired = ring->is_retired() || retired;
+                auto const position = ring->read([&](log_record_header header,
+                                                     std::byte const* payload)
+                                                 {
+                                                     logSchemas[header.schema - 1].load(std::memory_order_acquire)(payload, lines);
+                                                     lines += '\n';
+                                                     ++consumed;
+                                                 });
+                // written before the records are released, so flush returns only once they reached the sink
+                if (!lines.empty())
+                {
+                    sink(lines);
+                    lines.clear();
+                }
+                ring->release(position);
+            }
+            if (retired)
+            {
+                std::scoped_lock lock(ringsMutex);
+                std::erase_if(rings, [](auto const& ring)
+                              {
+                                  return ring->is_retired() && ring->drained();
+                              });
+                ringsVersion.fetch_add(1, std::memory_order_release);
+            }
+            // nothing can be logged concurrently with the destructor, so one more empty round after the stop request drained it all
+            if (!consumed)
+            {
+                if (stopping)
+                    return;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    inline static std::atomic<std::uint64_t> nextId = 0;
+
+    std::uint64_t const id = nextId.fetch_add(1, std::memory_order_relaxed);
+    sink_type sink;
+    size_t const ringCapacity;
+    std::mutex ringsMutex;
+    // shared with the thread_local lists of the logging threads, which may outlive the logger
+    std::vector<std::shared_ptr<log_ring>> rings;
+    std::atomic<size_t> ringsVersion = 0;
+    std::jthread consumer;
+};
+}
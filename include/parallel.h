@@ -0,0 +1,333 @@
+#pragma once
+#include "ctmap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <execution>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+/**
+* Fixed set of worker threads for running loops split into chunks.
+* The workers and the calling thread keep claiming the next unprocessed chunk until none are left,
+* so threads that are done early take over the work the others have not started yet.
+* Loops started from inside a running loop execute on the calling thread.
+*/
+class thread_pool
+{
+    struct job
+    {
+        void (*run)(void*, size_t, size_t);
+        void* function;
+        size_t count;
+        size_t chunkSize;
+        std::atomic<size_t> next = 0;
+        size_t busyWorkers = 0;
+        std::exception_ptr exception = nullptr;
+    };
+
+public:
+
+    explicit thread_pool(size_t threadCount = std::thread::hardware_concurrency())
+    {
+        threadCount = std::max(threadCount, 1uz);
+        workers.reserve(threadCount - 1);
+        for (auto index = 1uz; index < threadCount; ++index)
+            workers.emplace_back([this](std::stop_token stopToken)
+                                 {
+                                     work(stopToken);
+                                 });
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    thread_pool& operator=(thread_pool const&) = delete;
+
+    /**
+    * Number of threads working on a loop, including the calling thread.
+    */
+    size_t size() const noexcept
+    {
+        return workers.size() + 1;
+    }
+
+    /**
+    * Calls function(begin, end) for consecutive chunks of [0, count) and returns once all of them are done.
+    * The first exception thrown by function is rethrown after the remaining chunks were skipped.
+    */
+    template<typename _Function>
+    void for_each_chunk(size_t count,
+                        size_t chunkSize,
+                        _Function&& function)
+    {
+        chunkSize = std::max(chunkSize, 1uz);
+        if (workers.empty() || count <= chunkSize || currentPool == this)
+        {
+            for (auto begin = 0uz; begin < count; begin += chunkSize)
+                function(begin, std::min(begin + chunkSize, count));
+            return;
+        }
+
+        std::scoped_lock submitLock(submitMutex);
+        job current{
+            .run = [](void* function, size_t begin, size_t end)
+            {
+                (*static_cast<std::remove_reference_t<_Function>*>(function))(begin, end);
+            },
+            .function = std::addressof(function),
+            .count = count,
+            .chunkSize = chunkSize
+        };
+        {
+            std::scoped_lock lock(mutex);
+            active = &current;
+            ++generation;
+        }
+        wakeUp.notify_all();
+
+        run_chunks(current);
+
+        {
+            std::unique_lock lock(mutex);
+            done.wait(lock, [&]
+                      {
+                          return current.busyWorkers == 0;
+                      });
+            active = nullptr;
+        }
+        if (current.exception)
+            std::rethrow_exception(current.exception);
+    }
+
+private:
+
+    void run_chunks(job& current)
+    {
+        auto const previousPool = std::exchange(currentPool, this);
+        for (auto begin = current.next.fetch_add(current.chunkSize); begin < current.count; begin = current.next.fetch_add(current.chunkSize))
+        {
+            try
+            {
+                current.run(current.function, begin, std::min(begin + current.chunkSize, current.count));
+            }
+            catch (...)
+            {
+                std::scoped_lock lock(mutex);
+                if (!current.exception)
+                    current.exception = std::current_exception();
+                current.next = current.count;
+            }
+        }
+        currentPool = previousPool;
+    }
+
+    void work(std::stop_token stopToken)
+    {
+        size_t seenGeneration = 0;
+        std::unique_lock lock(mutex);
+        while (wakeUp.wait(lock, stopToken, [&]
+                           {
+                               return generation != seenGeneration;
+                           }))
+        {
+            seenGeneration = generation;
+            if (active == nullptr)
+                continue;
+
+            auto& current = *active;
+            ++current.busyWorkers;
+            lock.unlock();
+            run_chunks(current);
+            lock.lock();
+            if (--current.busyWorkers == 0)
+                done.notify_all();
+        }
+    }
+
+    inline static thread_local thread_pool const* currentPool = nullptr;
+
+    std::mutex submitMutex;
+    std::mutex mutex;
+    std::condition_variable_any wakeUp;
+    std::condition_variable done;
+    job* active = nullptr;
+    size_t generation = 0;
+    // declared last, so the workers are joined before anything they use is destroyed
+    std::vector<std::jthread> workers;
+};
+
+/**
+* Pool shared by all parallel algorithms that are not given a pool or an execution policy.
+*/
+inline thread_pool& default_thread_pool()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+/**
+* Combined size of the values a parallel algorithm hands to its function, all values if no tags are given.
+*/
+template<TagMap _TagMap, char_tag... _Tags>
+constexpr size_t selected_values_size_v = (sizeof(typename _TagMap::template get_tag_value_type_t<_Tags>) + ... + 0);
+
+template<TagMap _TagMap>
+constexpr size_t selected_values_size_v<_TagMap> = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+{
+    return (sizeof(typename std::tuple_element_t<_Indices, _TagMap>::value_type) + ... + 0);
+}(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+
+/**
+* Elements per chunk, so that the values touched by one chunk take up about 64 KiB,
+* but every thread still gets several chunks to balance the load.
+*/
+constexpr size_t parallel_chunk_size(size_t count,
+                                     size_t threadCount,
+                                     size_t valuesSize) noexcept
+{
+    constexpr size_t chunk_bytes = 64 * 1024;
+    constexpr size_t chunks_per_thread = 4;
+    auto const bySize = std::max(chunk_bytes / std::max(valuesSize, 1uz), 1uz);
+    auto const byThreads = std::max(count / (chunks_per_thread * std::max(threadCount, 1uz)), 1uz);
+    return std::min(bySize, byThreads);
+}
+
+template<std::ranges::random_access_range _Range>
+    requires TagMap<std::remove_cvref_t<std::ranges::range_reference_t<_Range>>>
+using range_tag_map_t = std::remove_cvref_t<std::ranges::range_reference_t<_Range>>;
+
+template<char_tag... _Tags, typename _TagMap, typename _Function>
+constexpr decltype(auto) apply_selected(_Function& function,
+                                        _TagMap& tagMap)
+{
+    if constexpr (sizeof...(_Tags) == 0)
+        return tagMap.template apply<all_tags>(function);
+    else
+        return tagMap.template apply<_Tags...>(function);
+}
+
+/**
+* Calls function with the values of the given tags (all values if no tags are given) of every tag map in range,
+* the same way tag_map::apply does, spread over the threads of pool.
+* range is any random access range of tag maps, e.g. a std::vector of tag maps or a tag_map_vector.
+*/
+template<char_tag... _Tags, std::ranges::random_access_range _Range, typename _Function>
+void parallel_for_each(thread_pool& pool,
+                       _Range&& range,
+                       _Function&& function)
+{
+    using tag_map_type = range_tag_map_t<_Range>;
+    auto const first = std::ranges::begin(range);
+    auto const count = size_t(std::ranges::distance(range));
+    pool.for_each_chunk(count, parallel_chunk_size(count, pool.size(), selected_values_size_v<tag_map_type, _Tags...>), [&](size_t begin, size_t end)
+                        {
+                            for (auto index = begin; index < end; ++index)
+                            {
+                                auto&& tagMap = first[index];
+                                apply_selected<_Tags...>(function, tagMap);
+                            }
+                        });
+}
+
+/**
+* parallel_for_each running the chunks through a standard execution policy.
+*/
+template<char_tag... _Tags, typename _ExecutionPolicy, std::ranges::random_access_range _Range, typename _Function>
+    requires std::is_execution_policy_v<std::remove_cvref_t<_ExecutionPolicy>>
+void parallel_for_each(_ExecutionPolicy&& policy,
+                       _Range&& range,
+                       _Function&& function)
+{
+    using tag_map_type = range_tag_map_t<_Range>;
+    auto const first = std::ranges::begin(range);
+    auto const count = size_t(std::ranges::distance(range));
+    auto const chunkSize = parallel_chunk_size(count, std::thread::hardware_concurrency(), selected_values_size_v<tag_map_type, _Tags...>);
+    std::vector<size_t> chunks((count + chunkSize - 1) / chunkSize);
+    std::iota(chunks.begin(), chunks.end(), 0uz);
+    std::for_each(std::forward<_ExecutionPolicy>(policy), chunks.begin(), chunks.end(), [&](size_t chunk)
+                  {
+                      for (auto index = chunk * chunkSize; index < std::min((chunk + 1) * chunkSize, count); ++index)
+                      {
+                          auto&& tagMap = first[index];
+                          apply_selected<_Tags...>(function, tagMap);
+                      }
+                  });
+}
+
+/**
+* Transforms the values of the given tags of every tag map in range like parallel_for_each
+* and combines the results with init through reduce.
+* Partial results are combined in the order of range, so the result does not depend on the thread count.
+*/
+template<char_tag... _Tags, std::ranges::random_access_range _Range, typename _Type, typename _Reduce, typename _Transform>
+_Type parallel_transform_reduce(thread_pool& pool,
+                                _Range&& range,
+                                _Type init,
+                                _Reduce reduce,
+                                _Transform transform)
+{
+    using tag_map_type = range_tag_map_t<_Range>;
+    auto const first = std::ranges::begin(range);
+    auto const count = size_t(std::ranges::distance(range));
+    auto const chunkSize = parallel_chunk_size(count, pool.size(), selected_values_size_v<tag_map_type, _Tags...>);
+    std::vector<std::optional<_Type>> partials((count + chunkSize - 1) / chunkSize);
+    pool.for_each_chunk(count, chunkSize, [&](size_t begin, size_t end)
+                        {
+                            auto&& firstTagMap = first[begin];
+                            _Type partial = apply_selected<_Tags...>(transform, firstTagMap);
+                            for (auto index = begin + 1; index < end; ++index)
+                            {
+                                auto&& tagMap = first[index];
+                                partial = reduce(std::move(partial), apply_selected<_Tags...>(transform, tagMap));
+                            }
+                            partials[begin / chunkSize].emplace(std::move(partial));
+                        });
+    for (auto& partial : partials)
+        init = reduce(std::move(init), std::move(*partial));
+    return init;
+}
+
+/**
+* parallel_transform_reduce running the chunks through a standard execution policy.
+*/
+template<char_tag... _Tags, typename _ExecutionPolicy, std::ranges::random_access_range _Range, typename _Type, typename _Reduce, typename _Transform>
+    requires std::is_execution_policy_v<std::remove_cvref_t<_ExecutionPolicy>>
+_Type parallel_transform_reduce(_ExecutionPolicy&& policy,
+                                _Range&& range,
+                                _Type init,
+                                _Reduce reduce,
+                                _Transform transform)
+{
+    using tag_map_type = range_tag_map_t<_Range>;
+    auto const first = std::ranges::begin(range);
+    auto const count = size_t(std::ranges::distance(range));
+    auto const chunkSize = parallel_chunk_size(count, std::thread::hardware_concurrency(), selected_values_size_v<tag_map_type, _Tags...>);
+    std::vector<size_t> chunks((count + chunkSize - 1) / chunkSize);
+    std::iota(chunks.begin(), chunks.end(), 0uz);
+    return std::transform_reduce(std::forward<_ExecutionPolicy>(policy), chunks.begin(), chunks.end(), std::move(init), reduce, [&](size_t chunk)
+                                 {
+                                     auto const begin = chunk * chunkSize;
+                                     auto&& firstTagMap = first[begin];
+                                     _Type partial = apply_selected<_Tags...>(transform, firstTagMap);
+                                     for (auto index = begin + 1; index < std::min(begin + chunkSize, count); ++index)
+                                     {
+                                         auto&& tagMap = first[index];
+                                         partial = reduce(std::move(partial), apply_selected<_Tags...>(transform, tagMap));
+                                     }
+                                     return partial;
+                                 });
+}
+}
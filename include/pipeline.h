@@ -0,0 +1,328 @@
+#pragma once
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <ranges>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+template<char_tag... _Tags>
+struct reads
+{};
+
+template<char_tag... _Tags>
+struct writes
+{};
+
+template<typename _Reads, typename _Writes, typename _Function>
+class pipeline_stage;
+
+/**
+* Step of a pipeline, calling function for every tag map with const references to the values of _ReadTags
+* followed by references to the values of _WriteTags, like apply with those tags.
+* A stage processes one batch at a time in order, so function may keep state between calls.
+*/
+template<char_tag... _ReadTags, char_tag... _WriteTags, typename _Function>
+class pipeline_stage<reads<_ReadTags...>, writes<_WriteTags...>, _Function>
+{
+    static_assert(tag_table<_ReadTags..., _WriteTags...>::unique, "stage lists a tag twice, tags that are read and written belong in writes only");
+
+public:
+
+    constexpr static std::array<std::string_view, sizeof...(_ReadTags)> read_tags = { _ReadTags.view()... };
+    constexpr static std::array<std::string_view, sizeof...(_WriteTags)> write_tags = { _WriteTags.view()... };
+
+    template<TagMap _TagMap>
+    constexpr static bool is_valid_for()
+    {
+        return (_TagMap::template is_tag_valid<_ReadTags>() && ...) && (_TagMap::template is_tag_valid<_WriteTags>() && ...);
+    }
+
+    constexpr explicit pipeline_stage(_Function function)
+        : function(std::move(function))
+    {}
+
+    template<typename _TagMap>
+    constexpr void operator()(_TagMap& tagMap)
+    {
+        function(std::as_const(tagMap).template get<_ReadTags>()..., tagMap.template get<_WriteTags>()...);
+    }
+
+private:
+
+    _Function function;
+};
+
+template<typename _Reads, typename _Writes, typename _Function>
+constexpr auto stage(_Function&& function)
+{
+    return pipeline_stage<_Reads, _Writes, std::decay_t<_Function>>(std::forward<_Function>(function));
+}
+
+constexpr bool tags_overlap(std::ranges::input_range auto const& lhs,
+                            std::ranges::input_range auto const& rhs)
+{
+    return std::ranges::any_of(lhs, [&](std::string_view tag)
+                               {
+                                   return std::ranges::find(rhs, tag) != std::ranges::end(rhs);
+                               });
+}
+
+/**
+* Whether _Later has to wait for _Earlier: it reads what _Earlier writes, or writes what _Earlier reads.
+*/
+template<typename _Earlier, typename _Later>
+constexpr bool stages_conflict()
+{
+    return tags_overlap(_Earlier::write_tags, _Later::read_tags) || tags_overlap(_Earlier::read_tags, _Later::write_tags)
+           || tags_overlap(_Earlier::write_tags, _Later::write_tags);
+}
+
+/**
+* Stages over tag maps of type _TagMap run as a dependency graph: a stage waits for the earlier stages it conflicts with
+* on the same batch, the others run concurrently. Batches are pipelined, a stage starts on the next batch as soon as
+* it is done with the previous one and its dependencies are done with the next.
+* Every tag is written by at most one stage, so the result does not depend on the scheduling.
+*/
+template<TagMap _TagMap, typename... _Stages>
+class pipeline
+{
+    static_assert((_Stages::template is_valid_for<_TagMap>() && ...), "stage uses a tag that is not part of the tag map");
+    static_assert([]
+                  {
+                      std::vector<std::string_view> writeTags;
+                      (writeTags.insert(writeTags.end(), _Stages::write_tags.begin(), _Stages::write_tags.end()), ...);
+                      std::ranges::sort(writeTags);
+                      return std::ranges::adjacent_find(writeTags) == writeTags.end();
+                  }(),
+                  "stages write the same tag, every tag can have only one writing stage");
+    static_assert([]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                  {
+                      return !(is_computed_value_v<typename std::tuple_element_t<_Indices, _TagMap>::value_type> || ...);
+                  }(std::make_index_sequence<std::tuple_size_v<_TagMap>>()),
+                  "pipelines cannot run on tag maps with computed values, stages writing a dependency would invalidate them while others read them");
+
+public:
+
+    constexpr static size_t stage_count = sizeof...(_Stages);
+
+    /**
+    * dependencies[later][earlier] is set if stage later waits for stage earlier on every batch.
+    */
+    constexpr static auto dependencies = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        using stage_tuple = std::tuple<_Stages...>;
+        std::array<std::array<bool, stage_count>, stage_count> result{};
+        ([&]<size_t _Later>(std::integral_constant<size_t, _Later>)
+         {
+             ((result[_Later][_Indices] = _Indices < _Later && stages_conflict<std::tuple_element_t<_Indices, stage_tuple>, std::tuple_element_t<_Later, stage_tuple>>()), ...);
+         }(std::integral_constant<size_t, _Indices>()), ...);
+        return result;
+    }(std::make_index_sequence<stage_count>());
+
+    constexpr explicit pipeline(_Stages... stages)
+        : stages(std::move(stages)...)
+    {}
+
+    /**
+    * Runs all stages on every tag map of range, e.g. a vector of _TagMap or a tag_map_vector, in batches of batchSize tag maps (or a size like that of
+    * parallel_for_each if 0) on the threads of pool. A pool of one thread runs all stages per tag map instead. The first exception thrown by a stage is rethrown once
+    * the running batches are done, the others are not started.
+    */
+    template<std::ranges::random_access_range _Range>
+    void run(thread_pool& pool,
+             _Range&& range,
+             size_t batchSize = 0)
+    {
+        auto const first = std::ranges::begin(range);
+        auto const count = size_t(std::ranges::distance(range));
+        if (count == 0 || stage_count == 0)
+            return;
+        // declaration order satisfies every dependency, one thread is best off calling all stages per tag map
+        if (pool.size() == 1)
+        {
+            for (auto index = 0uz; index < count; ++index)
+            {
+                auto&& tagMap = first[index];
+                std::apply([&](auto&... stages)
+                           {
+                               (stages(tagMap), ...);
+                           },
+                           stages);
+            }
+            return;
+        }
+        if (batchSize == 0)
+            batchSize = parallel_chunk_size(count, pool.size(), selected_values_size_v<_TagMap>);
+        schedule schedule(count, batchSize);
+        pool.for_each_chunk(pool.size(), 1, [&](size_t, size_t)
+                            {
+                                schedule.work([&](size_t stageIndex,
+                                                  size_t begin,
+                                                  size_t end)
+                                              {
+                                                  run_stage(stageIndex, first, begin, end);
+                                              });
+                            });
+        if (schedule.exception)
+            std::rethrow_exception(schedule.exception);
+    }
+
+    template<std::ranges::random_access_range _Range>
+    void run(_Range&& range,
+             size_t batchSize = 0)
+    {
+        run(default_thread_pool(), std::forward<_Range>(range), batchSize);
+    }
+
+private:
+
+    struct task
+    {
+        size_t batch;
+        size_t stage;
+
+        // earlier batches first, so batches leave the pipeline in order and early
+        friend bool operator<(task const& lhs, task const& rhs) noexcept
+        {
+            return std::pair(lhs.batch, lhs.stage) > std::pair(rhs.batch, rhs.stage);
+        }
+    };
+
+    /**
+    * Tasks of one run: a task is a stage on a batch, ready once its dependencies on the batch and the stage
+    * on the previous batch are done.
+    */
+    struct schedule
+    {
+        schedule(size_t count,
+                 size_t batchSize)
+            : count(count)
+            , batchSize(batchSize)
+            , batchCount((count + batchSize - 1) / batchSize)
+            , pending(std::make_unique<std::atomic<size_t>[]>(batchCount * stage_count))
+        {
+            for (auto batch = 0uz; batch < batchCount; ++batch)
+                for (auto stageIndex = 0uz; stageIndex < stage_count; ++stageIndex)
+                {
+                    auto const waitsFor = size_t(std::ranges::count(dependencies[stageIndex], true)) + (batch > 0 ? 1 : 0);
+                    pending[batch * stage_count + stageIndex].store(waitsFor, std::memory_order_relaxed);
+                    if (waitsFor == 0)
+                        ready.push({ batch, stageIndex });
+                }
+        }
+
+        template<typename _Function>
+        void work(_Function&& runStage)
+        {
+            std::unique_lock lock(mutex);
+            for (;;)
+            {
+                readyOrDone.wait(lock, [&]
+                                 {
+                                     return !ready.empty() || finished == batchCount * stage_count || exception;
+                                 });
+                if (ready.empty() || exception)
+                    return;
+                auto const current = ready.top();
+                ready.pop();
+                lock.unlock();
+                try
+                {
+                    runStage(current.stage, current.batch * batchSize, std::min((current.batch + 1) * batchSize, count));
+                }
+                catch (...)
+                {
+                    lock.lock();
+                    if (!exception)
+                        exception = std::current_exception();
+                    readyOrDone.notify_all();
+                    return;
+                }
+                lock.lock();
+                complete(current);
+            }
+        }
+
+        void complete(task const& done)
+        {
+            auto const release = [&](task const& next)
+            {
+                if (pending[next.batch * stage_count + next.stage].fetch_sub(1, std::memory_order_relaxed) == 1)
+                {
+                    ready.push(next);
+                    readyOrDone.notify_one();
+                }
+            };
+            for (auto stageIndex = done.stage + 1; stageIndex < stage_count; ++stageIndex)
+                if (dependencies[stageIndex][done.stage])
+                    release({ done.batch, stageIndex });
+            if (done.batch + 1 < batchCount)
+                release({ done.batch + 1, done.stage });
+            if (++finished == batchCount * stage_count)
+                readyOrDone.notify_all();
+        }
+
+        size_t const count;
+        size_t const batchSize;
+        size_t const batchCount;
+        // counted down under mutex, atomic only so the array needs no other initialization
+        std::unique_ptr<std::atomic<size_t>[]> pending;
+        std::mutex mutex;
+        std::condition_variable readyOrDone;
+        std::priority_queue<task> ready;
+        size_t finished = 0;
+        std::exception_ptr exception = nullptr;
+    };
+
+    template<typename _Iterator>
+    void run_stage(size_t stageIndex,
+                   _Iterator first,
+                   size_t begin,
+                   size_t end)
+    {
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            ((stageIndex == _Indices && (run_stage<_Indices>(first, begin, end), true)) || ...);
+        }(std::make_index_sequence<stage_count>());
+    }
+
+    template<size_t _Index, typename _Iterator>
+    void run_stage(_Iterator first,
+                   size_t begin,
+                   size_t end)
+    {
+        auto& current = std::get<_Index>(stages);
+        for (auto index = begin; index < end; ++index)
+        {
+            auto&& tagMap = first[index];
+            current(tagMap);
+        }
+    }
+
+    std::tuple<_Stages...> stages;
+};
+
+/**
+* Pipeline over tag maps of type _TagMap from stages made with stage<reads<...>, writes<...>>(function).
+*/
+template<TagMap _TagMap, typename... _Stages>
+constexpr auto make_pipeline(_Stages&&... stages)
+{
+    return pipeline<_TagMap, std::decay_t<_Stages>...>(std::forward<_Stages>(stages)...);
+}
+}
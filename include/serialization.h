@@ -0,0 +1,612 @@
+#pragma once
+#include "ctmap.h"
+#include "tracked_tag_map.h"
+#include "value_traits.h"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+class serialization_error : public std::runtime_error
+{
+public:
+
+    using std::runtime_error::runtime_error;
+};
+
+template<typename _Type>
+concept BinaryString = std::same_as<_Type, std::string> || std::same_as<_Type, std::string_view>;
+
+/**
+* Types copied bytewise. Class types are written member by member instead, their padding and
+* members like bools or the engaged flag of an optional cannot be copied or validated blindly.
+*/
+template<typename _Type>
+concept BinaryTrivial = std::is_arithmetic_v<_Type> || std::is_enum_v<_Type>;
+
+constexpr std::uint64_t schema_hash_combine(std::uint64_t hash,
+                                            std::uint64_t value) noexcept
+{
+    for (auto byte = 0; byte < 8; ++byte)
+        hash = (hash ^ ((value >> (8 * byte)) & 0xff)) * 0x100000001b3ull;
+    return hash;
+}
+
+constexpr std::uint64_t schema_hash_combine(std::uint64_t hash,
+                                            std::string_view string) noexcept
+{
+    for (auto character : string)
+        hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3ull;
+    return schema_hash_combine(hash, string.size());
+}
+
+/**
+* Structural fingerprint of a value type, equal for types with the same binary encoding.
+* std::string and std::string_view share one, so data written from one can be read into the other.
+*/
+template<typename _ValueType>
+constexpr std::uint64_t type_hash()
+{
+    constexpr std::uint64_t seed = 0xcbf29ce484222325ull;
+    if constexpr (TagMap<_ValueType>)
+    {
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            auto hash = schema_hash_combine(seed, 'M');
+            ((hash = schema_hash_combine(schema_hash_combine(hash, std::tuple_element_t<_Indices, _ValueType>::tag.view()),
+                                         type_hash<std::remove_cvref_t<typename std::tuple_element_t<_Indices, _ValueType>::value_type>>())), ...);
+            return hash;
+        }(stored_index_sequence_t<_ValueType>());
+    }
+    else if constexpr (is_optional_v<_ValueType>)
+        return schema_hash_combine(schema_hash_combine(seed, 'O'), type_hash<typename _ValueType::value_type>());
+    else if constexpr (BinaryString<_ValueType>)
+        return schema_hash_combine(seed, 'S');
+    else if constexpr (std::same_as<_ValueType, bool>)
+        return schema_hash_combine(seed, 'b');
+    else if constexpr (std::integral<_ValueType>)
+        return schema_hash_combine(schema_hash_combine(seed, std::is_signed_v<_ValueType> ? 'i' : 'u'), sizeof(_ValueType));
+    else if constexpr (std::floating_point<_ValueType>)
+        return schema_hash_combine(schema_hash_combine(seed, 'f'), sizeof(_ValueType));
+    else if constexpr (requires { std::tuple_size<_ValueType>::value; } && std::ranges::range<_ValueType>)
+        return schema_hash_combine(schema_hash_combine(schema_hash_combine(seed, 'F'), std::tuple_size_v<_ValueType>),
+                                   type_hash<std::ranges::range_value_t<_ValueType>>());
+    else if constexpr (requires { std::tuple_size<_ValueType>::value; })
+    {
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            auto hash = schema_hash_combine(seed, 'P');
+            ((hash = schema_hash_combine(hash, type_hash<std::remove_cvref_t<std::tuple_element_t<_Indices, _ValueType>>>())), ...);
+            return hash;
+        }(std::make_index_sequence<std::tuple_size_v<_ValueType>>());
+    }
+    else if constexpr (BinaryTrivial<_ValueType>)
+        return schema_hash_combine(schema_hash_combine(schema_hash_combine(seed, 'T'), sizeof(_ValueType)), alignof(_ValueType));
+    else if constexpr (std::ranges::range<_ValueType>)
+        return schema_hash_combine(schema_hash_combine(seed, 'A'), type_hash<std::ranges::range_value_t<_ValueType>>());
+    else
+        static_assert(sizeof(_ValueType) == 0, "type cannot be serialized");
+}
+
+/**
+* Fingerprint of the (tag, value type) pairs of a tag map and of the byte order, written in front of serialized data.
+* Computed values are neither written nor part of the fingerprint, deserializing their dependencies recomputes them.
+*/
+template<TagMap _TagMap>
+constexpr std::uint64_t schema_hash_v = schema_hash_combine(type_hash<_TagMap>(), std::endian::native == std::endian::little ? 'l' : 'B');
+
+/**
+* Whether all values of a tag map are arithmetic or enums, so records have a fixed size and are copied bytewise.
+*/
+template<TagMap _TagMap>
+constexpr bool is_trivially_serializable_v = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+{
+    return stored_index_sequence_t<_TagMap>::size() == sizeof...(_Indices)
+           && (BinaryTrivial<std::remove_cvref_t<typename std::tuple_element_t<_Indices, _TagMap>::value_type>> && ...);
+}(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+
+template<TagMap _TagMap>
+    requires is_trivially_serializable_v<_TagMap>
+constexpr size_t trivial_record_size_v = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+{
+    return (sizeof(typename std::tuple_element_t<_Indices, _TagMap>::value_type) + ... + 0);
+}(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+
+/**
+* Copies the values of a trivially serializable tag map next to each other, without padding.
+*/
+template<TagMap _TagMap>
+    requires is_trivially_serializable_v<_TagMap>
+std::byte* copy_to_bytes(_TagMap const& tagMap,
+                         std::byte* out) noexcept
+{
+    apply([&out](auto const&... taggedValues)
+          {
+              ((std::memcpy(out, std::addressof(taggedValues.value), sizeof(taggedValues.value)), out += sizeof(taggedValues.value)), ...);
+          },
+          tagMap);
+    return out;
+}
+
+template<TagMap _TagMap>
+    requires is_trivially_serializable_v<_TagMap>
+std::byte const* copy_from_bytes(std::byte const* in,
+                                 _TagMap& tagMap) noexcept
+{
+    apply([&in](auto&... taggedValues)
+          {
+              ((std::memcpy(std::addressof(taggedValues.value), in, sizeof(taggedValues.value)), in += sizeof(taggedValues.value)), ...);
+          },
+          tagMap);
+    return in;
+}
+
+/**
+* Throws unless a byte read into a bool is 0 or 1, the only object representations of bool.
+*/
+inline void check_bool_byte(std::byte byte)
+{
+    if (std::to_integer<unsigned int>(byte) > 1)
+        throw serialization_error("invalid bool in serialized data");
+}
+
+/**
+* Checks the bytes copy_from_bytes is about to copy into bool values.
+*/
+template<TagMap _TagMap>
+    requires is_trivially_serializable_v<_TagMap>
+void check_trivial_record(std::byte const* in)
+{
+    [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        ([&]
+         {
+             using value_type = std::remove_cvref_t<typename std::tuple_element_t<_Indices, _TagMap>::value_type>;
+             if constexpr (std::same_as<value_type, bool>)
+                 check_bool_byte(*in);
+             in += sizeof(value_type);
+         }(), ...);
+    }(std::make_index_sequence<std::tuple_size_v<_TagMap>>());
+}
+
+/**
+* Appends the binary encoding of values to a byte buffer.
+* Arithmetic and enum values are copied bytewise, strings and ranges are prefixed with a varint length,
+* optionals with a presence byte, tuples and arrays are written element by element.
+*/
+class binary_writer
+{
+public:
+
+    explicit binary_writer(std::vector<std::byte>& buffer) noexcept
+        : buffer(buffer)
+    {}
+
+    void write_bytes(void const* data,
+                     size_t size)
+    {
+        auto const offset = buffer.size();
+        buffer.resize(offset + size);
+        if (size)
+            std::memcpy(buffer.data() + offset, data, size);
+    }
+
+    void write_varint(std::uint64_t value)
+    {
+        std::byte bytes[10];
+        auto count = 0uz;
+        do
+        {
+            bytes[count++] = std::byte((value & 0x7f) | (value >= 0x80 ? 0x80 : 0));
+            value >>= 7;
+        }
+        while (value);
+        write_bytes(bytes, count);
+    }
+
+    template<typename _ValueType>
+    void write(_ValueType const& value)
+    {
+        if constexpr (TagMap<_ValueType>)
+        {
+            if constexpr (is_trivially_serializable_v<_ValueType>)
+                write_trivial_record(value);
+            else
+                [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                {
+                    (write(value.template get<_Indices>().value), ...);
+                }(stored_index_sequence_t<_ValueType>());
+        }
+        else if constexpr (is_optional_v<_ValueType>)
+        {
+            write_varint(value.has_value());
+            if (value)
+                write(*value);
+        }
+        else if constexpr (BinaryString<_ValueType>)
+        {
+            write_varint(value.size());
+            write_bytes(value.data(), value.size());
+        }
+        else if constexpr (BinaryTrivial<_ValueType>)
+            write_bytes(std::addressof(value), sizeof(_ValueType));
+        else if constexpr (requires { std::tuple_size<_ValueType>::value; })
+        {
+            if constexpr (std::ranges::range<_ValueType const>)
+            {
+                using element_type = std::ranges::range_value_t<_ValueType>;
+                if constexpr (std::ranges::contiguous_range<_ValueType const> && BinaryTrivial<element_type>)
+                    write_bytes(std::ranges::data(value), std::tuple_size_v<_ValueType> * sizeof(element_type));
+                else
+                    for (auto const& element : value)
+                        write(element);
+            }
+            else
+                [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                {
+                    (write(std::get<_Indices>(value)), ...);
+                }(std::make_index_sequence<std::tuple_size_v<_ValueType>>());
+        }
+        else
+        {
+            write_varint(std::ranges::size(value));
+            if constexpr (std::ranges::contiguous_range<_ValueType const> && BinaryTrivial<std::ranges::range_value_t<_ValueType>>)
+                write_bytes(std::ranges::data(value), std::ranges::size(value) * sizeof(std::ranges::range_value_t<_ValueType>));
+            else
+                for (auto const& element : value)
+                    write(element);
+        }
+    }
+
+private:
+
+    template<TagMap _TagMap>
+    void write_trivial_record(_TagMap const& tagMap)
+    {
+        auto const offset = buffer.size();
+        buffer.resize(offset + trivial_record_size_v<_TagMap>);
+        copy_to_bytes(tagMap, buffer.data() + offset);
+    }
+
+    std::vector<std::byte>& buffer;
+};
+
+/**
+* Reads values from their binary encoding.
+* std::string_view values point into the input.
+*/
+class binary_reader
+{
+public:
+
+    explicit binary_reader(std::span<std::byte const> input) noexcept
+        : input(input)
+    {}
+
+    std::span<std::byte const> read_bytes(size_t size)
+    {
+        if (size > input.size() - position)
+            throw serialization_error("unexpected end of serialized data");
+        auto const bytes = input.subspan(position, size);
+        position += size;
+        return bytes;
+    }
+
+    std::uint64_t read_varint()
+    {
+        std::uint64_t value = 0;
+        for (auto shift = 0; shift < 64; shift += 7)
+        {
+            auto const byte = std::to_integer<std::uint64_t>(read_bytes(1)[0]);
+            value |= (byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        throw serialization_error("invalid varint");
+    }
+
+    template<typename _ValueType>
+    void read(_ValueType& value)
+    {
+        if constexpr (TagMap<_ValueType>)
+        {
+            if constexpr (is_trivially_serializable_v<_ValueType>)
+                read_trivial_record(value);
+            else
+                [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                {
+                    (read(value.template get<_ValueType::template index_tag<_Indices>()>()), ...);
+                }(stored_index_sequence_t<_ValueType>());
+        }
+        else if constexpr (is_optional_v<_ValueType>)
+        {
+            if (read_varint())
+                read(value.emplace());
+            else
+                value.reset();
+        }
+        else if constexpr (BinaryString<_ValueType>)
+        {
+            auto const bytes = read_bytes(read_varint());
+            value = _ValueType(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+        }
+        else if constexpr (std::same_as<_ValueType, bool>)
+        {
+            auto const byte = read_bytes(1)[0];
+            check_bool_byte(byte);
+            value = byte != std::byte(0);
+        }
+        else if constexpr (BinaryTrivial<_ValueType>)
+            std::memcpy(std::addressof(value), read_bytes(sizeof(_ValueType)).data(), sizeof(_ValueType));
+        else if constexpr (requires { std::tuple_size<_ValueType>::value; })
+        {
+            if constexpr (std::ranges::range<_ValueType>)
+            {
+                using element_type = std::ranges::range_value_t<_ValueType>;
+                if constexpr (std::ranges::contiguous_range<_ValueType> && BinaryTrivial<element_type>)
+                {
+                    auto const bytes = read_bytes(std::tuple_size_v<_ValueType> * sizeof(element_type));
+                    if constexpr (std::same_as<element_type, bool>)
+                        std::ranges::for_each(bytes, check_bool_byte);
+                    std::memcpy(std::ranges::data(value), bytes.data(), bytes.size());
+                }
+                else
+                    for (auto& element : value)
+                        read(element);
+            }
+            else
+                [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                {
+                    (read(std::get<_Indices>(value)), ...);
+                }(std::make_index_sequence<std::tuple_size_v<_ValueType>>());
+        }
+        else
+        {
+            using element_type = std::ranges::range_value_t<_ValueType>;
+            auto const size = read_varint();
+            value.clear();
+            if constexpr (requires { value.resize(size); } && std::ranges::contiguous_range<_ValueType> && BinaryTrivial<element_type>)
+            {
+                // checked before multiplying, a crafted size could wrap around
+                if (size > (input.size() - position) / sizeof(element_type))
+                    throw serialization_error("unexpected end of serialized data");
+                auto const bytes = read_bytes(size * sizeof(element_type));
+                if constexpr (std::same_as<element_type, bool>)
+                    std::ranges::for_each(bytes, check_bool_byte);
+                value.resize(size);
+                std::memcpy(std::ranges::data(value), bytes.data(), bytes.size());
+            }
+            else
+            {
+                if constexpr (requires { value.reserve(size); })
+                    value.reserve(std::min<std::uint64_t>(size, input.size() - position));
+                for (auto index = 0uz; index < size; ++index)
+                {
+                    element_type element{};
+                    read(element);
+                    value.insert(value.end(), std::move(element));
+                }
+            }
+        }
+    }
+
+    bool at_end() const noexcept
+    {
+        return position == input.size();
+    }
+
+private:
+
+    template<TagMap _TagMap>
+    void read_trivial_record(_TagMap& tagMap)
+    {
+        auto const bytes = read_bytes(trivial_record_size_v<_TagMap>);
+        check_trivial_record<_TagMap>(bytes.data());
+        copy_from_bytes(bytes.data(), tagMap);
+    }
+
+    std::span<std::byte const> input;
+    size_t position = 0;
+};
+
+/**
+* Appends the schema hash and the encoding of tagMap to buffer.
+*/
+template<TagMap _TagMap>
+void serialize(_TagMap const& tagMap,
+               std::vector<std::byte>& buffer)
+{
+    binary_writer writer(buffer);
+    writer.write(schema_hash_v<_TagMap>);
+    writer.write(tagMap);
+}
+
+template<TagMap _TagMap>
+std::vector<std::byte> serialize(_TagMap const& tagMap)
+{
+    std::vector<std::byte> buffer;
+    serialize(tagMap, buffer);
+    return buffer;
+}
+
+/**
+* Appends the schema hash, the number of records and all records to buffer in one pass.
+* Takes any contiguous range of tag maps, e.g. a std::vector or a std::span of them.
+* Records of trivially serializable tag maps all have the same size, so the buffer is grown only once.
+*/
+template<std::ranges::contiguous_range _Range>
+    requires TagMap<std::ranges::range_value_t<_Range>>
+void serialize(_Range const& tagMaps,
+               std::vector<std::byte>& buffer)
+{
+    using tag_map_type = std::ranges::range_value_t<_Range>;
+    binary_writer writer(buffer);
+    writer.write(schema_hash_v<tag_map_type>);
+    writer.write_varint(std::ranges::size(tagMaps));
+    if constexpr (is_trivially_serializable_v<tag_map_type>)
+    {
+        auto const offset = buffer.size();
+        buffer.resize(offset + std::ranges::size(tagMaps) * trivial_record_size_v<tag_map_type>);
+        auto* out = buffer.data() + offset;
+        for (auto const& tagMap : tagMaps)
+            out = copy_to_bytes(tagMap, out);
+    }
+    else
+        for (auto const& tagMap : tagMaps)
+            writer.write(tagMap);
+}
+
+template<std::ranges::contiguous_range _Range>
+    requires TagMap<std::ranges::range_value_t<_Range>>
+std::vector<std::byte> serialize(_Range const& tagMaps)
+{
+    std::vector<std::byte> buffer;
+    serialize(tagMaps, buffer);
+    return buffer;
+}
+
+inline void check_schema_hash(binary_reader& reader,
+                              std::uint64_t expected)
+{
+    std::uint64_t hash;
+    reader.read(hash);
+    if (hash != expected)
+        throw serialization_error("schema hash mismatch");
+}
+
+/**
+* Reads a tag map written by serialize into an existing tag map, e.g. one created by tie_tag_map.
+*/
+template<typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+void deserialize(std::span<std::byte const> bytes,
+                 _TagMap&& tagMap)
+{
+    binary_reader reader(bytes);
+    check_schema_hash(reader, schema_hash_v<std::remove_cvref_t<_TagMap>>);
+    reader.read(tagMap);
+    if (!reader.at_end())
+        throw serialization_error("trailing bytes after serialized data");
+}
+
+template<TagMap _TagMap>
+    requires std::default_initializable<_TagMap>
+_TagMap deserialize(std::span<std::byte const> bytes)
+{
+    _TagMap tagMap;
+    deserialize(bytes, tagMap);
+    return tagMap;
+}
+
+/**
+* Reads records written by the batch serialize.
+*/
+template<TagMap _TagMap>
+    requires std::default_initializable<_TagMap>
+std::vector<_TagMap> deserialize_batch(std::span<std::byte const> bytes)
+{
+    binary_reader reader(bytes);
+    check_schema_hash(reader, schema_hash_v<_TagMap>);
+    std::vector<_TagMap> tagMaps;
+    reader.read(tagMaps);
+    if (!reader.at_end())
+        throw serialization_error("trailing bytes after serialized data");
+    return tagMaps;
+}
+
+/**
+* Appends the schema hash and the dirty tagged values of tagMap, each prefixed with its index in declared order.
+* Sending this after every update and calling clear_dirty replicates a tag map by transferring only what changed.
+*/
+template<TaggedValue... _TaggedValues>
+void serialize_dirty(tracked_tag_map<_TaggedValues...> const& tagMap,
+                     std::vector<std::byte>& buffer)
+{
+    using values_type = typename tracked_tag_map<_TaggedValues...>::values_type;
+    binary_writer writer(buffer);
+    writer.write(schema_hash_v<values_type>);
+    // computed values are recomputed by the receiver, even if they were marked dirty
+    auto count = 0uz;
+    tagMap.for_each_dirty([&count](auto const& taggedValue)
+                          {
+                              count += !is_computed_value_v<typename std::remove_cvref_t<decltype(taggedValue)>::value_type>;
+                          });
+    writer.write_varint(count);
+    tagMap.for_each_dirty([&writer](auto const& taggedValue)
+                          {
+                              using tagged_value_type = std::remove_cvref_t<decltype(taggedValue)>;
+                              if constexpr (!is_computed_value_v<typename tagged_value_type::value_type>)
+                              {
+                                  constexpr auto index = values_type::template tag_index<tagged_value_type::tag>();
+                                  writer.write_varint(index);
+                                  writer.write(taggedValue.value);
+                              }
+                          });
+}
+
+template<TaggedValue... _TaggedValues>
+std::vector<std::byte> serialize_dirty(tracked_tag_map<_TaggedValues...> const& tagMap)
+{
+    std::vector<std::byte> buffer;
+    serialize_dirty(tagMap, buffer);
+    return buffer;
+}
+
+template<TagMap _Schema, typename _TagMap>
+void read_delta(binary_reader& reader,
+                _TagMap& tagMap)
+{
+    check_schema_hash(reader, schema_hash_v<_Schema>);
+    for (auto count = reader.read_varint(); count > 0; --count)
+    {
+        auto const index = reader.read_varint();
+        bool const valid = [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return ((index == _Indices && (reader.read(tagMap.template get<_Schema::template index_tag<_Indices>()>()), true)) || ...);
+        }(stored_index_sequence_t<_Schema>());
+        if (!valid)
+            throw serialization_error("invalid tag index in serialized delta");
+    }
+    if (!reader.at_end())
+        throw serialization_error("trailing bytes after serialized data");
+}
+
+/**
+* Reads the tagged values written by serialize_dirty into a tag map holding the previous state.
+*/
+template<typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+void apply_delta(std::span<std::byte const> bytes,
+                 _TagMap&& tagMap)
+{
+    binary_reader reader(bytes);
+    read_delta<std::remove_cvref_t<_TagMap>>(reader, tagMap);
+}
+
+/**
+* Reads the tagged values written by serialize_dirty into a tracked tag map, marking them dirty,
+* so updates can be forwarded further.
+*/
+template<TaggedValue... _TaggedValues>
+void apply_delta(std::span<std::byte const> bytes,
+                 tracked_tag_map<_TaggedValues...>& tagMap)
+{
+    binary_reader reader(bytes);
+    read_delta<typename tracked_tag_map<_TaggedValues...>::values_type>(reader, tagMap);
+}
+}
@@ -0,0 +1,399 @@
+#pragma once
+#include "ctmap.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace ctmap
+{
+template<typename _ValueType>
+concept SimdArithmetic = std::is_arithmetic_v<_ValueType> && !std::same_as<_ValueType, bool> && !std::same_as<_ValueType, long double>;
+
+/**
+* Instruction set the kernels below run with, chosen once at runtime.
+* generic is whatever the translation unit was compiled for (SSE2 on x86-64, NEON on AArch64).
+*/
+enum class simd_target
+{
+    generic,
+    avx2
+};
+
+inline simd_target detected_simd_target() noexcept
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    static simd_target const target = []
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? simd_target::avx2 : simd_target::generic;
+    }();
+    return target;
+#else
+    return simd_target::generic;
+#endif
+}
+
+/**
+* Vector of _Bytes / sizeof(_ValueType) values, compiled to the registers of the instruction set of the function using it.
+* Without compiler support for vector types, kernels get _Bytes == 0 and run scalar loops.
+*/
+template<SimdArithmetic _ValueType, size_t _Bytes>
+struct simd_vector
+{
+#if defined(__GNUC__)
+    typedef _ValueType type __attribute__((vector_size(_Bytes)));
+#endif
+};
+
+template<SimdArithmetic _ValueType, size_t _Bytes>
+using simd_vector_t = typename simd_vector<_ValueType, _Bytes>::type;
+
+/**
+* Integer of the same width as _ValueType, the element type of comparison results of vectors of _ValueType.
+*/
+template<SimdArithmetic _ValueType>
+using simd_mask_t = std::conditional_t<sizeof(_ValueType) == 1, std::int8_t,
+                    std::conditional_t<sizeof(_ValueType) == 2, std::int16_t,
+                    std::conditional_t<sizeof(_ValueType) == 4, std::int32_t, std::int64_t>>>;
+
+// Vectors are only ever local variables of the kernels, never parameters or return values,
+// so the kernels can be compiled for several instruction sets without their calling conventions getting in the way.
+
+struct sum_kernel
+{
+    template<size_t _Bytes, SimdArithmetic _ValueType>
+    static _ValueType run(std::span<_ValueType const> values)
+    {
+        _ValueType result = 0;
+        auto index = 0uz;
+        if constexpr (_Bytes != 0)
+        {
+            using vector = simd_vector_t<_ValueType, _Bytes>;
+            constexpr size_t lanes = _Bytes / sizeof(_ValueType);
+            // four independent sums hide the latency of the additions
+            vector sums[4] = {};
+            for (; index + 4 * lanes <= values.size(); index += 4 * lanes)
+                for (auto part = 0uz; part < 4; ++part)
+                {
+                    vector block;
+                    std::memcpy(&block, values.data() + index + part * lanes, sizeof(block));
+                    sums[part] += block;
+                }
+            sums[0] = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+            for (auto lane = 0uz; lane < lanes; ++lane)
+                result += sums[0][lane];
+        }
+        for (; index < values.size(); ++index)
+            result += values[index];
+        return result;
+    }
+};
+
+template<bool _Max>
+struct extremum_kernel
+{
+    template<size_t _Bytes, SimdArithmetic _ValueType>
+    static std::optional<_ValueType> run(std::span<_ValueType const> values)
+    {
+        if (values.empty())
+            return std::nullopt;
+
+        _ValueType result = values.front();
+        auto index = 0uz;
+        if constexpr (_Bytes != 0)
+        {
+            using vector = simd_vector_t<_ValueType, _Bytes>;
+            constexpr size_t lanes = _Bytes / sizeof(_ValueType);
+            if (values.size() >= 2 * lanes)
+            {
+                vector extrema[2];
+                std::memcpy(&extrema, values.data(), sizeof(extrema));
+                for (index = 2 * lanes; index + 2 * lanes <= values.size(); index += 2 * lanes)
+                    for (auto part = 0uz; part < 2; ++part)
+                    {
+                        vector block;
+                        std::memcpy(&block, values.data() + index + part * lanes, sizeof(block));
+                        if constexpr (_Max)
+                            extrema[part] = extrema[part] < block ? block : extrema[part];
+                        else
+                            extrema[part] = block < extrema[part] ? block : extrema[part];
+                    }
+                for (auto part = 0uz; part < 2; ++part)
+                    for (auto lane = 0uz; lane < lanes; ++lane)
+                        result = better(extrema[part][lane], result);
+            }
+        }
+        for (; index < values.size(); ++index)
+            result = better(values[index], result);
+        return result;
+    }
+
+private:
+
+    template<SimdArithmetic _ValueType>
+    static _ValueType better(_ValueType lhs,
+                             _ValueType rhs)
+    {
+        if constexpr (_Max)
+            return rhs < lhs ? lhs : rhs;
+        else
+            return lhs < rhs ? lhs : rhs;
+    }
+};
+
+struct transform_kernel
+{
+    template<size_t _Bytes, SimdArithmetic _ValueType, typename _Function>
+    static void run(std::span<_ValueType const> values,
+                    std::span<_ValueType> out,
+                    _Function& function)
+    {
+        auto index = 0uz;
+        if constexpr (_Bytes != 0)
+        {
+            using vector = simd_vector_t<_ValueType, _Bytes>;
+            constexpr size_t lanes = _Bytes / sizeof(_ValueType);
+            for (; index + lanes <= values.size(); index += lanes)
+            {
+                vector block;
+                std::memcpy(&block, values.data() + index, sizeof(block));
+                for (auto lane = 0uz; lane < lanes; ++lane)
+                    block[lane] = static_cast<_ValueType>(function(_ValueType(block[lane])));
+                std::memcpy(out.data() + index, &block, sizeof(block));
+            }
+        }
+        for (; index < values.size(); ++index)
+            out[index] = static_cast<_ValueType>(function(values[index]));
+    }
+};
+
+struct filter_kernel
+{
+    template<size_t _Bytes, SimdArithmetic _ValueType, typename _Predicate>
+    static size_t run(std::span<_ValueType const> values,
+                      std::span<_ValueType> out,
+                      _Predicate& predicate)
+    {
+        auto count = 0uz;
+        auto index = 0uz;
+        if constexpr (_Bytes != 0)
+        {
+            using vector = simd_vector_t<_ValueType, _Bytes>;
+            using mask = simd_vector_t<simd_mask_t<_ValueType>, _Bytes>;
+            constexpr size_t lanes = _Bytes / sizeof(_ValueType);
+            for (; index + lanes <= values.size(); index += lanes)
+            {
+                vector block;
+                mask keep;
+                std::memcpy(&block, values.data() + index, sizeof(block));
+                for (auto lane = 0uz; lane < lanes; ++lane)
+                    keep[lane] = predicate(_ValueType(block[lane])) ? 1 : 0;
+                // branchless compaction, every value is written and only kept ones advance the output
+                for (auto lane = 0uz; lane < lanes; ++lane)
+                {
+                    out[count] = block[lane];
+                    count += size_t(keep[lane]);
+                }
+            }
+        }
+        for (; index < values.size(); ++index)
+        {
+            out[count] = values[index];
+            count += predicate(values[index]) ? 1 : 0;
+        }
+        return count;
+    }
+};
+
+template<typename _Kernel, typename... _Args>
+[[gnu::flatten]] auto run_simd_kernel_generic(_Args&&... args)
+{
+#if defined(__GNUC__)
+    return _Kernel::template run<16>(std::forward<_Args>(args)...);
+#else
+    return _Kernel::template run<0>(std::forward<_Args>(args)...);
+#endif
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+template<typename _Kernel, typename... _Args>
+[[gnu::target("avx2"), gnu::flatten]] auto run_simd_kernel_avx2(_Args&&... args)
+{
+    return _Kernel::template run<32>(std::forward<_Args>(args)...);
+}
+#endif
+
+template<typename _Kernel, typename... _Args>
+auto run_simd_kernel(_Args&&... args)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (detected_simd_target() == simd_target::avx2)
+        return run_simd_kernel_avx2<_Kernel>(std::forward<_Args>(args)...);
+#endif
+    return run_simd_kernel_generic<_Kernel>(std::forward<_Args>(args)...);
+}
+
+/**
+* Sum of values. Floating point values are added in a different order than a plain loop would.
+*/
+template<SimdArithmetic _ValueType>
+_ValueType simd_sum(std::span<_ValueType const> values)
+{
+    return run_simd_kernel<sum_kernel>(values);
+}
+
+/**
+* Smallest value, or std::nullopt for no values.
+*/
+template<SimdArithmetic _ValueType>
+std::optional<_ValueType> simd_min(std::span<_ValueType const> values)
+{
+    return run_simd_kernel<extremum_kernel<false>>(values);
+}
+
+/**
+* Largest value, or std::nullopt for no values.
+*/
+template<SimdArithmetic _ValueType>
+std::optional<_ValueType> simd_max(std::span<_ValueType const> values)
+{
+    return run_simd_kernel<extremum_kernel<true>>(values);
+}
+
+/**
+* Writes function(value) for every value to out, which needs at least as many elements and may be values itself.
+* function is inlined into the vectorized loop, so it should be a plain arithmetic lambda.
+*/
+template<SimdArithmetic _ValueType, typename _Function>
+    requires std::is_invocable_v<_Function&, _ValueType>
+void simd_transform(std::span<_ValueType const> values,
+                    std::span<_ValueType> out,
+                    _Function function)
+{
+    run_simd_kernel<transform_kernel>(values, out, function);
+}
+
+/**
+* Copies the values predicate holds for to the front of out and returns their number.
+* out needs at least as many elements as values and may be values itself.
+*/
+template<SimdArithmetic _ValueType, typename _Predicate>
+    requires std::predicate<_Predicate&, _ValueType>
+size_t simd_filter(std::span<_ValueType const> values,
+                   std::span<_ValueType> out,
+                   _Predicate predicate)
+{
+    return run_simd_kernel<filter_kernel>(values, out, predicate);
+}
+
+/**
+* Overloads for contiguous ranges such as std::vector or std::span of non-const values, viewed as the spans above.
+*/
+template<std::ranges::contiguous_range _Range>
+    requires SimdArithmetic<std::ranges::range_value_t<_Range>>
+auto simd_sum(_Range const& values)
+{
+    return simd_sum(std::span<std::ranges::range_value_t<_Range> const>(values));
+}
+
+template<std::ranges::contiguous_range _Range>
+    requires SimdArithmetic<std::ranges::range_value_t<_Range>>
+auto simd_min(_Range const& values)
+{
+    return simd_min(std::span<std::ranges::range_value_t<_Range> const>(values));
+}
+
+template<std::ranges::contiguous_range _Range>
+    requires SimdArithmetic<std::ranges::range_value_t<_Range>>
+auto simd_max(_Range const& values)
+{
+    return simd_max(std::span<std::ranges::range_value_t<_Range> const>(values));
+}
+
+template<std::ranges::contiguous_range _Range, typename _OutRange, typename _Function>
+    requires SimdArithmetic<std::ranges::range_value_t<_Range>>
+             && std::constructible_from<std::span<std::ranges::range_value_t<_Range>>, _OutRange&>
+             && std::is_invocable_v<_Function&, std::ranges::range_value_t<_Range>>
+void simd_transform(_Range const& values,
+                    _OutRange&& out,
+                    _Function function)
+{
+    using value_type = std::ranges::range_value_t<_Range>;
+    simd_transform(std::span<value_type const>(values), std::span<value_type>(out), std::move(function));
+}
+
+template<std::ranges::contiguous_range _Range, typename _OutRange, typename _Predicate>
+    requires SimdArithmetic<std::ranges::range_value_t<_Range>>
+             && std::constructible_from<std::span<std::ranges::range_value_t<_Range>>, _OutRange&>
+             && std::predicate<_Predicate&, std::ranges::range_value_t<_Range>>
+size_t simd_filter(_Range const& values,
+                   _OutRange&& out,
+                   _Predicate predicate)
+{
+    using value_type = std::ranges::range_value_t<_Range>;
+    return simd_filter(std::span<value_type const>(values), std::span<value_type>(out), std::move(predicate));
+}
+
+/**
+* Anything storing the values of a tag contiguously, like tag_map_vector.
+*/
+template<typename _Columns, char_tag _Tag>
+concept ColumnsOf = requires(_Columns& columns) { { columns.template column<_Tag>() } -> std::ranges::contiguous_range; };
+
+template<char_tag _Tag, typename _Columns>
+    requires ColumnsOf<_Columns const, _Tag>
+auto column_sum(_Columns const& columns)
+{
+    return simd_sum(std::span(std::as_const(columns).template column<_Tag>()));
+}
+
+template<char_tag _Tag, typename _Columns>
+    requires ColumnsOf<_Columns const, _Tag>
+auto column_min(_Columns const& columns)
+{
+    return simd_min(std::span(std::as_const(columns).template column<_Tag>()));
+}
+
+template<char_tag _Tag, typename _Columns>
+    requires ColumnsOf<_Columns const, _Tag>
+auto column_max(_Columns const& columns)
+{
+    return simd_max(std::span(std::as_const(columns).template column<_Tag>()));
+}
+
+/**
+* Replaces every value of the column of _Tag by function(value).
+*/
+template<char_tag _Tag, typename _Columns, typename _Function>
+    requires ColumnsOf<_Columns, _Tag>
+void column_transform(_Columns& columns,
+                      _Function function)
+{
+    std::span column(columns.template column<_Tag>());
+    simd_transform(column, column, std::move(function));
+}
+
+/**
+* Values of the column of _Tag predicate holds for.
+*/
+template<char_tag _Tag, typename _Columns, typename _Predicate>
+    requires ColumnsOf<_Columns const, _Tag>
+auto column_filter(_Columns const& columns,
+                   _Predicate predicate)
+{
+    std::span column(std::as_const(columns).template column<_Tag>());
+    std::vector<std::remove_const_t<typename decltype(column)::element_type>> result(column.size());
+    result.resize(simd_filter(column, std::span(result), std::move(predicate)));
+    return result;
+}
+}
@@ -0,0 +1,242 @@
+#pragma once
+#include "ctmap.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+/**
+* One presence bit per tagged value, packed into the smallest unsigned integers that hold them.
+*/
+template<size_t _Size>
+class presence_mask
+{
+    using word_type = std::conditional_t<_Size <= 8, std::uint8_t,
+                      std::conditional_t<_Size <= 16, std::uint16_t,
+                      std::conditional_t<_Size <= 32, std::uint32_t, std::uint64_t>>>;
+
+    constexpr static size_t word_bits = 8 * sizeof(word_type);
+
+public:
+
+    constexpr bool test(size_t index) const noexcept
+    {
+        return (words[index / word_bits] >> (index % word_bits)) & 1;
+    }
+
+    constexpr void set(size_t index) noexcept
+    {
+        words[index / word_bits] |= word_type(word_type(1) << (index % word_bits));
+    }
+
+    constexpr void reset(size_t index) noexcept
+    {
+        words[index / word_bits] &= word_type(~(word_type(1) << (index % word_bits)));
+    }
+
+    constexpr size_t count() const noexcept
+    {
+        auto result = 0uz;
+        for (auto word : words)
+            result += size_t(std::popcount(word));
+        return result;
+    }
+
+    friend constexpr bool operator==(presence_mask const&, presence_mask const&) = default;
+
+private:
+
+    std::array<word_type, (_Size + word_bits - 1) / word_bits> words{};
+};
+
+/**
+* Tag map where every tagged value may be absent, like a tag map of std::optional values,
+* but with all presence flags in one bitmask instead of a flag plus padding per value.
+* Values are stored in a packed_tag_map together with the bitmask, which therefore usually fits into their padding.
+* Absent values are default constructed.
+*/
+template<TaggedValue... _TaggedValues>
+class sparse_tag_map
+{
+    static_assert(!(std::is_reference_v<typename _TaggedValues::value_type> || ...), "sparse_tag_map cannot store references");
+    static_assert((std::is_default_constructible_v<typename _TaggedValues::value_type> && ...), "sparse_tag_map values need to be default constructible");
+    static_assert(!((_TaggedValues::tag == char_tag("")) || ...), "sparse_tag_map reserves the empty tag for its presence bitmask");
+
+public:
+
+    /**
+    * Tag the presence bitmask is stored under, next to the tagged values.
+    */
+    constexpr static char_tag presence_tag = "";
+
+    using values_type = packed_tag_map<_TaggedValues..., tagged_value<presence_tag, presence_mask<sizeof...(_TaggedValues)>>>;
+
+    template<char_tag _Tag>
+    using get_tagged_value_type_t = typename values_type::template get_tagged_value_type_t<_Tag>;
+    template<char_tag _Tag>
+    using get_tag_value_type_t = typename values_type::template get_tag_value_type_t<_Tag>;
+
+    /**
+    * Map with all tagged values absent.
+    */
+    constexpr sparse_tag_map() = default;
+
+    template<char_tag _Tag>
+    constexpr static bool is_tag_valid()
+    {
+        return values_type::template is_tag_valid<_Tag>() && !(_Tag == presence_tag);
+    }
+
+    template<char_tag _Tag>
+        requires (is_tag_valid<_Tag>())
+    constexpr static size_t tag_index()
+    {
+        return values_type::template tag_index<_Tag>();
+    }
+
+    template<char_tag _Tag>
+    constexpr bool has() const noexcept
+    {
+        constexpr auto index = tag_index<_Tag>();
+        return presence().test(index);
+    }
+
+    /**
+    * Number of tagged values present.
+    */
+    constexpr size_t count() const noexcept
+    {
+        return presence().count();
+    }
+
+    /**
+    * Value of a tag, which has to be present.
+    */
+    template<char_tag _Tag>
+        requires (is_tag_valid<_Tag>())
+    constexpr auto& get() noexcept
+    {
+        return values.template get<_Tag>();
+    }
+
+    template<char_tag _Tag>
+        requires (is_tag_valid<_Tag>())
+    constexpr auto const& get() const noexcept
+    {
+        return values.template get<_Tag>();
+    }
+
+    /**
+    * Pointer to the value of a tag, nullptr if it is absent.
+    */
+    template<char_tag _Tag>
+    constexpr auto* get_if() noexcept
+    {
+        return has<_Tag>() ? &get<_Tag>() : nullptr;
+    }
+
+    template<char_tag _Tag>
+    constexpr auto const* get_if() const noexcept
+    {
+        return has<_Tag>() ? &get<_Tag>() : nullptr;
+    }
+
+    template<char_tag _Tag, typename... _Args>
+        requires std::constructible_from<get_tag_value_type_t<_Tag>, _Args...>
+    constexpr auto& emplace(_Args&&... args)
+    {
+        auto& value = get<_Tag>();
+        value = get_tag_value_type_t<_Tag>(std::forward<_Args>(args)...);
+        constexpr auto index = tag_index<_Tag>();
+        presence().set(index);
+        return value;
+    }
+
+    /**
+    * Makes a tag absent and releases what its value holds.
+    */
+    template<char_tag _Tag>
+    constexpr void reset()
+    {
+        get<_Tag>() = get_tag_value_type_t<_Tag>();
+        constexpr auto index = tag_index<_Tag>();
+        presence().reset(index);
+    }
+
+    /**
+    * Calls function with every tagged value that is present, in declared order.
+    */
+    template<typename _Function>
+    constexpr void for_each_present(_Function&& function)
+    {
+        for_each_present_impl(*this, function);
+    }
+
+    template<typename _Function>
+    constexpr void for_each_present(_Function&& function) const
+    {
+        for_each_present_impl(*this, function);
+    }
+
+    /**
+    * Values of all tags, absent ones default constructed, followed by the bitmask under presence_tag.
+    */
+    constexpr values_type const& all_values() const noexcept
+    {
+        return values;
+    }
+
+    constexpr std::array<bool, sizeof...(_TaggedValues)> present() const noexcept
+    {
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return std::array<bool, sizeof...(_TaggedValues)>{ presence().test(_Indices)... };
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+    }
+
+    /**
+    * Equal if the same tags are present with equal values.
+    */
+    friend constexpr bool operator==(sparse_tag_map const& lhs,
+                                     sparse_tag_map const& rhs)
+    {
+        if (lhs.presence() != rhs.presence())
+            return false;
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return ((!lhs.presence().test(_Indices) || lhs.values.template get<_Indices>() == rhs.values.template get<_Indices>()) && ...);
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+    }
+
+private:
+
+    constexpr auto& presence() noexcept
+    {
+        return values.template get<presence_tag>();
+    }
+
+    constexpr auto const& presence() const noexcept
+    {
+        return values.template get<presence_tag>();
+    }
+
+    template<typename _SparseTagMap, typename _Function>
+    constexpr static void for_each_present_impl(_SparseTagMap& sparseTagMap,
+                                                _Function& function)
+    {
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            ((sparseTagMap.presence().test(_Indices) ? void(function(sparseTagMap.values.template get<_Indices>())) : void()), ...);
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+    }
+
+    values_type values;
+};
+}
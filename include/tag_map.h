@@ -1,18 +1,80 @@
 #pragma once
 #include "char_tag.h"
+#include "computed_value.h"
 #include "tagged_value.h"
 
+#include <algorithm>
+#include <array>
+#include <compare>
 #include <concepts>
+#include <cstddef>
+#include <memory>
 #if __cpp_static_assert >= 202306L
 #include <string>
 #endif
 #include <tuple>
+#include <type_traits>
 
 
 namespace ctmap
 {
+/**
+* Layout policy storing tagged values in the order of their declaration.
+*/
+struct declared_layout
+{
+    template<TaggedValue... _TaggedValues>
+    constexpr static std::array<size_t, sizeof...(_TaggedValues)> storage_order()
+    {
+        std::array<size_t, sizeof...(_TaggedValues)> order{};
+        for (auto index = 0uz; index < order.size(); ++index)
+            order[index] = index;
+        return order;
+    }
+};
+
+/**
+* Layout policy storing tagged values ordered by decreasing alignment and size to minimize padding.
+* Empty value types are stored last, where std::tuple can overlap them with other members.
+*/
+struct packed_layout
+{
+    template<TaggedValue... _TaggedValues>
+    constexpr static std::array<size_t, sizeof...(_TaggedValues)> storage_order()
+    {
+        constexpr std::array<size_t, sizeof...(_TaggedValues)> alignments = { alignof(_TaggedValues)... };
+        constexpr std::array<size_t, sizeof...(_TaggedValues)> sizes = { (std::is_empty_v<_TaggedValues> ? 0 : sizeof(_TaggedValues))... };
+        auto order = declared_layout::storage_order<_TaggedValues...>();
+        // ties keep the declared order, std::stable_sort is not constexpr
+        std::ranges::sort(order, [&](size_t lhs, size_t rhs)
+                          {
+                              if ((sizes[lhs] == 0) != (sizes[rhs] == 0))
+                                  return sizes[rhs] == 0;
+                              if (alignments[lhs] != alignments[rhs])
+                                  return alignments[lhs] > alignments[rhs];
+                              if (sizes[lhs] != sizes[rhs])
+                                  return sizes[lhs] > sizes[rhs];
+                              return lhs < rhs;
+                          });
+        return order;
+    }
+};
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+class basic_tag_map;
+
+/**
+* Tag map storing its tagged values in declaration order.
+*/
+template<TaggedValue... _TaggedValues>
+using tag_map = basic_tag_map<declared_layout, _TaggedValues...>;
+
+/**
+* Tag map storing its tagged values in an order that minimizes padding.
+* The interface (get, apply, structured bindings, formatting) still follows the declared order.
+*/
 template<TaggedValue... _TaggedValues>
-class tag_map;
+using packed_tag_map = basic_tag_map<packed_layout, _TaggedValues...>;
 
 template<typename>
 struct tag_map_from_tuple;
@@ -28,12 +90,8 @@ template<typename>
 struct is_tag_map : std::false_type
 {};
 
-template<typename _Type>
-    requires requires(_Type)
-{
-    typename _Type::tagged_tuple;
-}
-struct is_tag_map<_Type> : std::is_same<_Type, tag_map_from_tuple_t<typename _Type::tagged_tuple>>
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct is_tag_map<basic_tag_map<_Layout, _TaggedValues...>> : std::true_type
 {};
 
 template<typename _Type>
@@ -45,67 +103,144 @@ concept TagMap = is_tag_map_v<_Type>;
 /**
 * Compile time map between unique tags and assigned types.
 * Iterable like a tuple, but every type has a name (in the form of a tag).
+* The layout policy only decides the order of the tagged values in memory.
 */
-template<TaggedValue... _TaggedValues>
-class tag_map
+template<typename _Layout, TaggedValue... _TaggedValues>
+class basic_tag_map
 {
-    static_assert(is_unique_tag_list_v<_TaggedValues::tag...>, "tags are not unique");
+    using tag_table = ctmap::tag_table<_TaggedValues::tag...>;
+
+    static_assert(tag_table::unique, "tags are not unique");
 
-    template<char_tag _Tag, size_t _Index>
-    constexpr static size_t tag_index_impl()
+    // storageOrder maps storage positions to declared indices, storagePositions the other way around
+    constexpr static auto storageOrder = _Layout::template storage_order<_TaggedValues...>();
+    constexpr static auto storagePositions = []
     {
-        return 0;
-    }
+        std::array<size_t, sizeof...(_TaggedValues)> positions{};
+        for (auto position = 0uz; position < positions.size(); ++position)
+            positions[storageOrder[position]] = position;
+        return positions;
+    }();
+
+public:
+
+    using tagged_tuple = std::tuple<_TaggedValues...>;
+    using layout_type = _Layout;
 
-    template<char_tag _Tag, size_t _Index, TaggedValue _TaggedValue, TaggedValue... _OtherTaggedValues>
-    constexpr static size_t tag_index_impl()
+private:
+
+    using storage_tuple = typename decltype([]<size_t... _Positions>(std::index_sequence<_Positions...>)
+                                            {
+                                                return std::type_identity<std::tuple<std::tuple_element_t<storageOrder[_Positions], tagged_tuple>...>>();
+                                            }(std::make_index_sequence<sizeof...(_TaggedValues)>()))::type;
+
+    template<typename _Tuple>
+    constexpr static storage_tuple make_storage(_Tuple&& taggedValueTuple)
     {
-        if constexpr (_TaggedValue::tag == _Tag)
-            return _Index;
+        if constexpr (std::is_same_v<storage_tuple, tagged_tuple>)
+            return storage_tuple(std::forward<_Tuple>(taggedValueTuple));
         else
-            return tag_index_impl<_Tag, _Index + 1, _OtherTaggedValues...>();
+            return [&]<size_t... _Positions>(std::index_sequence<_Positions...>)
+            {
+                return storage_tuple(std::get<storageOrder[_Positions]>(std::forward<_Tuple>(taggedValueTuple))...);
+            }(std::make_index_sequence<sizeof...(_TaggedValues)>());
     }
 
-    template<char_tag _Tag>
-    constexpr static size_t tag_index_impl()
+    /**
+    * Storage whose tagged values are constructed in place from the elements of a tuple of values or tagged values,
+    * uses-allocator construction passes allocator on to the values that take one.
+    */
+    template<typename _Allocator, typename _Tuple>
+    constexpr static storage_tuple make_storage(std::allocator_arg_t,
+                                                _Allocator const& allocator,
+                                                _Tuple&& tuple)
     {
-        return tag_index_impl<_Tag, 0, _TaggedValues...>();
+        return [&]<size_t... _Positions>(std::index_sequence<_Positions...>)
+        {
+            return storage_tuple(std::allocator_arg, allocator, std::get<storageOrder[_Positions]>(std::forward<_Tuple>(tuple))...);
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
     }
 
 public:
 
-    using tagged_tuple = std::tuple<_TaggedValues...>;
+    template<TaggedValue... _OtherTaggedValues>
+    using rebind_t = basic_tag_map<_Layout, _OtherTaggedValues...>;
 
-    constexpr tag_map() noexcept = default;
+    constexpr basic_tag_map() noexcept = default;
 
     template<typename _Type>
         requires std::constructible_from<tagged_tuple, _Type>
-    constexpr explicit tag_map(_Type&& value)
-        : taggedValues(std::forward<_Type>(value))
+    constexpr explicit basic_tag_map(_Type&& value)
+        : taggedValues(make_storage(std::forward<_Type>(value)))
     {}
 
     template<typename... _ValueTypes>
         requires (sizeof...(_ValueTypes) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, _ValueTypes> && ...)
-    constexpr explicit tag_map(_ValueTypes&&... values)
-        : taggedValues(std::forward_as_tuple(std::forward<_ValueTypes>(values)...))
+    constexpr explicit basic_tag_map(_ValueTypes&&... values)
+        : taggedValues(make_storage(std::forward_as_tuple(std::forward<_ValueTypes>(values)...)))
     {}
 
-    template<TaggedValue... _OtherTaggedValues>
+    template<typename _OtherLayout, TaggedValue... _OtherTaggedValues>
         requires (sizeof...(_OtherTaggedValues) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, _OtherTaggedValues> && ...)
-    constexpr explicit tag_map(tag_map<_OtherTaggedValues...>&& other)
-        : taggedValues(std::move(other.taggedValues))
+    constexpr explicit basic_tag_map(basic_tag_map<_OtherLayout, _OtherTaggedValues...>&& other)
+        : taggedValues(make_storage(forward_as_tagged_tuple(std::move(other))))
     {}
 
-    template<TaggedValue... _OtherTaggedValues>
+    template<typename _OtherLayout, TaggedValue... _OtherTaggedValues>
         requires (sizeof...(_OtherTaggedValues) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, _OtherTaggedValues> && ...)
-    constexpr explicit tag_map(tag_map<_OtherTaggedValues...> const& other)
-        : taggedValues(other.taggedValues)
+    constexpr explicit basic_tag_map(basic_tag_map<_OtherLayout, _OtherTaggedValues...> const& other)
+        : taggedValues(make_storage(forward_as_tagged_tuple(other)))
+    {}
+
+    /**
+    * Allocator extended constructors, like those of std::tuple.
+    * Every value that is allocator aware for _Allocator is constructed with allocator, e.g. with a std::pmr::memory_resource* for std::pmr containers.
+    */
+    template<typename _Allocator>
+    constexpr basic_tag_map(std::allocator_arg_t,
+                            _Allocator const& allocator)
+        : taggedValues(std::allocator_arg, allocator)
+    {}
+
+    template<typename _Allocator, typename... _ValueTypes>
+        requires (sizeof...(_ValueTypes) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, std::allocator_arg_t, _Allocator const&, _ValueTypes> && ...)
+    constexpr explicit basic_tag_map(std::allocator_arg_t,
+                                     _Allocator const& allocator,
+                                     _ValueTypes&&... values)
+        : taggedValues(make_storage(std::allocator_arg, allocator, std::forward_as_tuple(std::forward<_ValueTypes>(values)...)))
+    {}
+
+    /**
+    * From a tuple of values or tagged values in declared order.
+    */
+    template<typename _Allocator, typename... _Types>
+        requires (sizeof...(_Types) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, std::allocator_arg_t, _Allocator const&, _Types> && ...)
+    constexpr explicit basic_tag_map(std::allocator_arg_t,
+                                     _Allocator const& allocator,
+                                     std::tuple<_Types...>&& tuple)
+        : taggedValues(make_storage(std::allocator_arg, allocator, std::move(tuple)))
+    {}
+
+    template<typename _Allocator, typename _OtherLayout, TaggedValue... _OtherTaggedValues>
+        requires (sizeof...(_OtherTaggedValues) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, std::allocator_arg_t, _Allocator const&, _OtherTaggedValues> && ...)
+    constexpr explicit basic_tag_map(std::allocator_arg_t,
+                                     _Allocator const& allocator,
+                                     basic_tag_map<_OtherLayout, _OtherTaggedValues...>&& other)
+        : taggedValues(make_storage(std::allocator_arg, allocator, forward_as_tagged_tuple(std::move(other))))
+    {}
+
+    template<typename _Allocator, typename _OtherLayout, TaggedValue... _OtherTaggedValues>
+        requires (sizeof...(_OtherTaggedValues) == sizeof...(_TaggedValues)) && (std::constructible_from<_TaggedValues, std::allocator_arg_t, _Allocator const&, _OtherTaggedValues const&> && ...)
+    constexpr explicit basic_tag_map(std::allocator_arg_t,
+                                     _Allocator const& allocator,
+                                     basic_tag_map<_OtherLayout, _OtherTaggedValues...> const& other)
+        : taggedValues(make_storage(std::allocator_arg, allocator, forward_as_tagged_tuple(other)))
     {}
 
     template<char_tag _Tag>
     constexpr static bool is_tag_valid()
     {
-        return ((_Tag == _TaggedValues::tag) || ...);
+        return tag_table::contains(_Tag.view());
     }
 
     template<char_tag _Tag>
@@ -118,11 +253,11 @@ public:
                       "tag is not valid for the tag map"
 #endif
         );
-        return tag_index_impl<_Tag>();
+        return tag_table::find(_Tag.view());
     }
 
     template<size_t _Index>
-    constexpr static size_t index_tag()
+    constexpr static auto index_tag()
     {
         return std::tuple_element_t<_Index, tagged_tuple>::tag;
     }
@@ -132,51 +267,76 @@ public:
     template<char_tag _Tag>
     using get_tag_value_type_t = typename get_tagged_value_type_t<_Tag>::value_type;
 
+    /**
+    * Mutable access to a tag invalidates the computed values depending on it, computed values themselves are always const.
+    */
     template<char_tag _Tag>
     constexpr auto& get()&
     {
-        return std::get<tag_index<_Tag>()>(taggedValues).value;
+        constexpr auto index = tag_index<_Tag>();
+        if constexpr (is_computed<index>())
+            return std::as_const(*this).template get<_Tag>();
+        else
+        {
+            invalidate_dependents<_Tag>();
+            return std::get<storagePositions[index]>(taggedValues).value;
+        }
     }
 
     template<char_tag _Tag>
         requires (!std::is_reference_v<get_tag_value_type_t<_Tag>>)
     constexpr auto const& get() const&
     {
-        return std::get<tag_index<_Tag>()>(taggedValues).value;
+        constexpr auto index = tag_index<_Tag>();
+        if constexpr (is_computed<index>())
+            return std::get<storagePositions[index]>(taggedValues).value.get(*this);
+        else
+            return std::get<storagePositions[index]>(taggedValues).value;
     }
 
     template<char_tag _Tag>
         requires (std::is_reference_v<get_tag_value_type_t<_Tag>>)
     constexpr auto&& get() const&
     {
-        return std::get<tag_index<_Tag>()>(taggedValues).value;
+        return std::get<storagePositions[tag_index<_Tag>()]>(taggedValues).value;
     }
 
     template<char_tag _Tag>
     constexpr auto&& get()&&
     {
-        return std::get<tag_index<_Tag>()>(std::move(taggedValues)).value;
+        constexpr auto index = tag_index<_Tag>();
+        if constexpr (is_computed<index>())
+            return std::move(std::as_const(*this).template get<_Tag>());
+        else
+        {
+            invalidate_dependents<_Tag>();
+            return std::get<storagePositions[index]>(std::move(taggedValues)).value;
+        }
     }
 
     template<char_tag _Tag>
         requires (!std::is_reference_v<get_tag_value_type_t<_Tag>>)
     constexpr auto const&& get() const&&
     {
-        return std::get<tag_index<_Tag>()>(std::move(taggedValues)).value;
+        constexpr auto index = tag_index<_Tag>();
+        if constexpr (is_computed<index>())
+            return std::move(std::as_const(*this).template get<_Tag>());
+        else
+            return std::get<storagePositions[index]>(std::move(taggedValues)).value;
     }
 
     template<char_tag _Tag>
         requires (std::is_reference_v<get_tag_value_type_t<_Tag>>)
     constexpr auto&& get() const&&
     {
-        return std::get<tag_index<_Tag>()>(std::move(taggedValues)).value;
+        return std::get<storagePositions[tag_index<_Tag>()]>(std::move(taggedValues)).value;
     }
 
     template<char_tag... _Tags>
         requires (sizeof...(_Tags) != 1)
     constexpr auto get()&
     {
-        return std::tie(get<_Tags>()...);
+        return tie_values<_Tags...>();
     }
 
     template<char_tag... _Tags>
@@ -190,7 +350,7 @@ public:
         requires (sizeof...(_Tags) != 1)
     constexpr auto get()&&
     {
-        return std::forward_as_tuple(std::move(*this).template get<_Tags>()...);
+        return forward_values<_Tags...>();
     }
 
     template<char_tag... _Tags>
@@ -203,31 +363,33 @@ public:
     template<size_t _Index>
     constexpr auto& get()&
     {
-        return std::get<_Index>(taggedValues);
+        invalidate_dependents<index_tag<_Index>()>();
+        return std::get<storagePositions[_Index]>(taggedValues);
     }
 
     template<size_t _Index>
     constexpr auto const& get() const&
     {
-        return std::get<_Index>(taggedValues);
+        return std::get<storagePositions[_Index]>(taggedValues);
     }
 
     template<size_t _Index>
     constexpr auto&& get()&&
     {
-        return std::get<_Index>(std::move(taggedValues));
+        invalidate_dependents<index_tag<_Index>()>();
+        return std::get<storagePositions[_Index]>(std::move(taggedValues));
     }
 
     template<size_t _Index>
     constexpr auto const&& get() const&&
     {
-        return std::get<_Index>(std::move(taggedValues));
+        return std::get<storagePositions[_Index]>(std::move(taggedValues));
     }
 
     template<all_tags_t>
     constexpr auto get()&
     {
-        return std::tie(get<_TaggedValues::tag>()...);
+        return tie_values<_TaggedValues::tag...>();
     }
 
     template<all_tags_t>
@@ -239,7 +401,7 @@ public:
     template<all_tags_t>
     constexpr auto get()&&
     {
-        return std::forward_as_tuple(std::move(*this).template get<_TaggedValues::tag>()...);
+        return forward_values<_TaggedValues::tag...>();
     }
 
     template<all_tags_t>
@@ -248,9 +410,14 @@ public:
         return std::forward_as_tuple(std::move(*this).template get<_TaggedValues::tag>()...);
     }
 
+    /**
+    * Computed values depending on the applied tags are invalidated again after function returns,
+    * as it may read them through the tag map before it modifies their dependencies.
+    */
     template<all_tags_t, typename _Function>
     constexpr auto apply(_Function&& function)&
     {
+        [[maybe_unused]] invalidate_guard<_TaggedValues::tag...> guard{*this};
         return std::apply(std::forward<_Function>(function), get<all_tags>());
     }
 
@@ -263,6 +430,7 @@ public:
     template<all_tags_t, typename _Function>
     constexpr auto apply(_Function&& function)&&
     {
+        [[maybe_unused]] invalidate_guard<_TaggedValues::tag...> guard{*this};
         return std::apply(std::forward<_Function>(function), std::move(*this).template get<all_tags>());
     }
 
@@ -275,94 +443,228 @@ public:
     template<char_tag... _Tags, typename _Function>
     constexpr auto apply(_Function&& function)&
     {
-        return std::apply(std::forward<_Function>(function), get<_Tags...>());
+        [[maybe_unused]] invalidate_guard<_Tags...> guard{*this};
+        return std::apply(std::forward<_Function>(function), tie_values<_Tags...>());
     }
 
     template<char_tag... _Tags, typename _Function>
     constexpr auto apply(_Function&& function) const&
     {
-        return std::apply(std::forward<_Function>(function), get<_Tags...>());
+        return std::apply(std::forward<_Function>(function), std::tie(get<_Tags>()...));
     }
 
     template<char_tag... _Tags, typename _Function>
     constexpr auto apply(_Function&& function)&&
     {
-        return std::apply(std::forward<_Function>(function), std::move(*this).template get<_Tags...>());
+        [[maybe_unused]] invalidate_guard<_Tags...> guard{*this};
+        return std::apply(std::forward<_Function>(function), forward_values<_Tags...>());
     }
 
     template<char_tag... _Tags, typename _Function>
     constexpr auto apply(_Function&& function) const&&
     {
-        return std::apply(std::forward<_Function>(function), std::move(*this).template get<_Tags...>());
+        return std::apply(std::forward<_Function>(function), std::forward_as_tuple(std::move(*this).template get<_Tags>()...));
     }
 
 private:
 
-    template<TagMap _LhsTagMap, TagMap _RhsTagMap>
-    friend constexpr auto operator==(_LhsTagMap const&,
-                                     _RhsTagMap const&);
+    template<typename _OtherLayout, TaggedValue... _OtherTaggedValues>
+    friend class basic_tag_map;
 
-    template<TagMap _LhsTagMap, TagMap _RhsTagMap>
-    friend constexpr auto operator<=>(_LhsTagMap const&,
-                                      _RhsTagMap const&);
+    template<size_t _Index>
+    constexpr static bool is_computed()
+    {
+        return is_computed_value_v<typename std::tuple_element_t<_Index, tagged_tuple>::value_type>;
+    }
+
+    constexpr static bool has_computed = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        return (is_computed<_Indices>() || ...);
+    }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+
+    template<size_t _Index, size_t _DependencyIndex>
+    constexpr static bool depends_on()
+    {
+        if constexpr (is_computed<_Index>())
+            return std::tuple_element_t<_Index, tagged_tuple>::value_type::template depends_on<index_tag<_DependencyIndex>()>();
+        else
+            return false;
+    }
+
+    /**
+    * Whether computed values depend on each other in a cycle, themselves included, found by a depth first search.
+    * Invalidating any of them would recurse forever.
+    */
+    constexpr static bool has_computed_cycle = []
+    {
+        constexpr auto count = sizeof...(_TaggedValues);
+        constexpr auto dependencies = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            std::array<std::array<bool, count>, count> result{};
+            ([&]<size_t _Index>(std::integral_constant<size_t, _Index>)
+             {
+                 ((result[_Index][_Indices] = depends_on<_Index, _Indices>()), ...);
+             }(std::integral_constant<size_t, _Indices>()), ...);
+            return result;
+        }(std::make_index_sequence<count>());
+        enum class visit_state
+        {
+            unvisited,
+            on_path,
+            done
+        };
+        std::array<visit_state, count> states{};
+        auto const reaches_path = [&](auto const& self,
+                                      size_t index) -> bool
+        {
+            states[index] = visit_state::on_path;
+            for (auto dependency = 0uz; dependency < count; ++dependency)
+                if (dependencies[index][dependency]
+                    && (states[dependency] == visit_state::on_path || (states[dependency] == visit_state::unvisited && self(self, dependency))))
+                    return true;
+            states[index] = visit_state::done;
+            return false;
+        };
+        for (auto index = 0uz; index < count; ++index)
+            if (states[index] == visit_state::unvisited && reaches_path(reaches_path, index))
+                return true;
+        return false;
+    }();
+
+    static_assert(!has_computed_cycle, "computed values cannot depend on themselves, directly or through other computed values");
+
+    /**
+    * Marks the computed values depending on any of _Tags stale, and transitively the computed values depending on those.
+    */
+    template<char_tag... _Tags>
+    constexpr void invalidate_dependents() const
+    {
+        if constexpr (has_computed)
+            [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+            {
+                (invalidate_if_dependent<_Indices, _Tags...>(), ...);
+            }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+    }
 
-    template<typename _Function, TagMap _TagMap>
-    friend constexpr auto apply(_Function&&,
-                                _TagMap&);
+    template<size_t _Index, char_tag... _Tags>
+    constexpr void invalidate_if_dependent() const
+    {
+        if constexpr (is_computed<_Index>())
+        {
+            using computed_type = typename std::tuple_element_t<_Index, tagged_tuple>::value_type;
+            if constexpr ((computed_type::template depends_on<_Tags>() || ...))
+            {
+                std::get<storagePositions[_Index]>(taggedValues).value.invalidate();
+                invalidate_dependents<index_tag<_Index>()>();
+            }
+        }
+    }
+
+    template<char_tag... _Tags>
+    struct invalidate_guard
+    {
+        constexpr ~invalidate_guard()
+        {
+            tagMap.template invalidate_dependents<_Tags...>();
+        }
 
-    template<typename _Function, TagMap _TagMap>
-    friend constexpr auto apply(_Function&&,
-                                _TagMap const&);
+        basic_tag_map const& tagMap;
+    };
+
+    /**
+    * References to the values of _Tags. Computed values among them may be read after some of their dependencies were
+    * already invalidated, so the dependents are invalidated once more when all references are taken.
+    */
+    template<char_tag... _Tags>
+    constexpr auto tie_values()
+    {
+        auto values = std::tie(get<_Tags>()...);
+        invalidate_dependents<_Tags...>();
+        return values;
+    }
 
-    template<typename _Function, TagMap _TagMap>
-    friend constexpr auto apply(_Function&&,
-                                _TagMap&&);
+    template<char_tag... _Tags>
+    constexpr auto forward_values()
+    {
+        auto values = std::forward_as_tuple(std::move(*this).template get<_Tags>()...);
+        invalidate_dependents<_Tags...>();
+        return values;
+    }
 
-    template<typename _Function, TagMap _TagMap>
-    friend constexpr auto apply(_Function&&,
-                                _TagMap const&&);
+    storage_tuple taggedValues;
+};
 
-    template<char_tag... _Tags, typename _Function, TagMap _TagMap>
-        requires (sizeof...(_Tags) > 0)
-    friend constexpr auto apply(_Function&&,
-                                _TagMap&);
+/**
+* Tuple of references to the tagged values of a tag map in declared order, like std::forward_as_tuple.
+*/
+template<typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+constexpr auto forward_as_tagged_tuple(_TagMap&& tagMap)
+{
+    return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        return std::forward_as_tuple(std::forward<_TagMap>(tagMap).template get<_Indices>()...);
+    }(std::make_index_sequence<std::tuple_size_v<typename std::remove_cvref_t<_TagMap>::tagged_tuple>>());
+}
 
-    template<char_tag... _Tags, typename _Function, TagMap _TagMap>
-        requires (sizeof...(_Tags) > 0)
-    friend constexpr auto apply(_Function&&,
-                                _TagMap const&);
+/**
+* Indices of the tagged values a tag map stores, in declared order. Computed values are left out,
+* they follow from the others, so writers like to_json or serialize and diff go over these only.
+*/
+template<TagMap _TagMap>
+struct stored_indices
+{
+private:
 
-    template<char_tag... _Tags, typename _Function, TagMap _TagMap>
-        requires (sizeof...(_Tags) > 0)
-    friend constexpr auto apply(_Function&&,
-                                _TagMap&&);
+    using tagged_tuple = typename _TagMap::tagged_tuple;
 
-    template<char_tag... _Tags, typename _Function, TagMap _TagMap>
-        requires (sizeof...(_Tags) > 0)
-    friend constexpr auto apply(_Function&&,
-                                _TagMap const&&);
+    constexpr static auto indices = []<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        constexpr std::array<bool, sizeof...(_Indices)> computed{ is_computed_value_v<typename std::tuple_element_t<_Indices, tagged_tuple>::value_type>... };
+        std::array<size_t, size_t(std::ranges::count(computed, false))> result{};
+        auto out = result.begin();
+        for (auto index = 0uz; index < computed.size(); ++index)
+            if (!computed[index])
+                *out++ = index;
+        return result;
+    }(std::make_index_sequence<std::tuple_size_v<tagged_tuple>>());
 
-    template<TagMap... _TagMaps>
-    friend constexpr auto tag_map_cat(_TagMaps&&...);
+    template<size_t... _Positions>
+    constexpr static auto make_sequence(std::index_sequence<_Positions...>)
+    {
+        return std::index_sequence<indices[_Positions]...>();
+    }
 
-    template<TagMap... _TagMaps>
-    friend constexpr auto tag_map_cat(_TagMaps const&...);
+public:
 
-    tagged_tuple taggedValues;
+    using type = decltype(make_sequence(std::make_index_sequence<indices.size()>()));
 };
 
+template<TagMap _TagMap>
+using stored_index_sequence_t = typename stored_indices<_TagMap>::type;
+
 template<TagMap _LhsTagMap, TagMap _RhsTagMap>
 constexpr auto operator==(_LhsTagMap const& lhs,
                           _RhsTagMap const& rhs)
 {
-    return lhs.taggedValues == rhs.taggedValues;
+    return forward_as_tagged_tuple(lhs) == forward_as_tagged_tuple(rhs);
 }
 
 template<TagMap _LhsTagMap, TagMap _RhsTagMap>
 constexpr auto operator<=>(_LhsTagMap const& lhs,
                            _RhsTagMap const& rhs)
 {
-    return lhs.taggedValues <=> rhs.taggedValues;
+    return forward_as_tagged_tuple(lhs) <=> forward_as_tagged_tuple(rhs);
+}
+
+/**
+* Whether the values of the given tags are equal, for tag maps that may differ in their other tags.
+*/
+template<char_tag... _Tags, typename _LhsTagMap, typename _RhsTagMap>
+constexpr bool equal_tags(_LhsTagMap const& lhs,
+                          _RhsTagMap const& rhs)
+{
+    return ((lhs.template get<_Tags>() == rhs.template get<_Tags>()) && ...);
 }
 
 template<char_tag ..._Tags, TagMap _TagMap>
@@ -441,28 +743,28 @@ template<typename _Function, TagMap _TagMap>
 constexpr auto apply(_Function&& function,
                      _TagMap& tagMap)
 {
-    return std::apply(std::forward<_Function>(function), tagMap.taggedValues);
+    return std::apply(std::forward<_Function>(function), forward_as_tagged_tuple(tagMap));
 }
 
 template<typename _Function, TagMap _TagMap>
 constexpr auto apply(_Function&& function,
                      _TagMap const& tagMap)
 {
-    return std::apply(std::forward<_Function>(function), tagMap.taggedValues);
+    return std::apply(std::forward<_Function>(function), forward_as_tagged_tuple(tagMap));
 }
 
 template<typename _Function, TagMap _TagMap>
 constexpr auto apply(_Function&& function,
                      _TagMap&& tagMap)
 {
-    return std::apply(std::forward<_Function>(function), std::move(tagMap.taggedValues));
+    return std::apply(std::forward<_Function>(function), forward_as_tagged_tuple(std::move(tagMap)));
 }
 
 template<typename _Function, TagMap _TagMap>
 constexpr auto apply(_Function&& function,
                      _TagMap const&& tagMap)
 {
-    return std::apply(std::forward<_Function>(function), std::move(tagMap.taggedValues));
+    return std::apply(std::forward<_Function>(function), forward_as_tagged_tuple(std::move(tagMap)));
 }
 
 template<char_tag... _Tags, typename _Function, TagMap _TagMap>
@@ -471,7 +773,7 @@ constexpr auto apply(_Function&& function,
                      _TagMap& tagMap)
 {
     return std::apply(std::forward<_Function>(function),
-                      std::tie(std::get<_TagMap::template tag_index<_Tags>()>(tagMap.taggedValues)...));
+                      std::tie(tagMap.template get<_TagMap::template tag_index<_Tags>()>()...));
 }
 
 template<char_tag... _Tags, typename _Function, TagMap _TagMap>
@@ -480,7 +782,7 @@ constexpr auto apply(_Function&& function,
                      _TagMap const& tagMap)
 {
     return std::apply(std::forward<_Function>(function),
-                      std::tie(std::get<_TagMap::template tag_index<_Tags>()>(tagMap.taggedValues)...));
+                      std::tie(tagMap.template get<_TagMap::template tag_index<_Tags>()>()...));
 }
 
 template<char_tag... _Tags, typename _Function, TagMap _TagMap>
@@ -489,7 +791,7 @@ constexpr auto apply(_Function&& function,
                      _TagMap&& tagMap)
 {
     return std::apply(std::forward<_Function>(function),
-                      std::forward_as_tuple(std::get<_TagMap::template tag_index<_Tags>()>(std::forward<decltype(tagMap.taggedValues)>(tagMap.taggedValues))...));
+                      std::forward_as_tuple(std::move(tagMap).template get<_TagMap::template tag_index<_Tags>()>()...));
 }
 
 template<char_tag... _Tags, typename _Function, TagMap _TagMap>
@@ -498,7 +800,7 @@ constexpr auto apply(_Function&& function,
                      _TagMap const&& tagMap)
 {
     return std::apply(std::forward<_Function>(function),
-                      std::forward_as_tuple(std::get<_TagMap::template tag_index<_Tags>()>(std::forward<decltype(tagMap.taggedValues)>(tagMap.taggedValues))...));
+                      std::forward_as_tuple(std::move(tagMap).template get<_TagMap::template tag_index<_Tags>()>()...));
 }
 
 template<TaggedValue... _TaggedValues>
@@ -532,7 +834,20 @@ template<char_tag... _Tags, typename... _ValueTypes>
 constexpr auto make_tag_map(_ValueTypes&&... values)
 {
     static_assert(sizeof...(_Tags) == sizeof...(_ValueTypes), "sizes of tags and values mismatch");
-    return tag_map<decltype(make_tagged<_Tags>(std::forward<_ValueTypes>(values)))...>(make_tagged<_Tags>(std::forward<_ValueTypes>(values))...);
+    return tag_map<make_tagged_t<_Tags, _ValueTypes>...>(std::forward<_ValueTypes>(values)...);
+}
+
+/**
+* make_tag_map constructing the values with allocator, see the allocator extended constructors of basic_tag_map.
+*/
+template<char_tag... _Tags, typename _Allocator, typename... _ValueTypes>
+    requires (sizeof...(_Tags) > 0)
+constexpr auto make_tag_map(std::allocator_arg_t const&,
+                            _Allocator&& allocator,
+                            _ValueTypes&&... values)
+{
+    static_assert(sizeof...(_Tags) == sizeof...(_ValueTypes), "sizes of tags and values mismatch");
+    return tag_map<make_tagged_t<_Tags, _ValueTypes>...>(std::allocator_arg, allocator, std::forward<_ValueTypes>(values)...);
 }
 
 template<char_tag... _Tags, typename... _ValueTypes>
@@ -551,35 +866,134 @@ constexpr auto forward_as_tag_map(_ValueTypes&&... values)
     return tag_map<tagged_value<_Tags, _ValueTypes&&>...>(std::forward<_ValueTypes>(values)...);
 }
 
-template<TagMap... _TagMaps>
+/**
+* Tag map of the tagged values of all tagMaps. Every value is constructed in place in the result,
+* copied from lvalue arguments and moved from rvalue arguments.
+*/
+template<typename... _TagMaps>
+    requires (TagMap<std::remove_cvref_t<_TagMaps>> && ...)
 constexpr auto tag_map_cat(_TagMaps&&... tagMaps)
 {
-    return make_tag_map(std::tuple_cat(std::move(tagMaps.taggedValues)...));
+    using result_type = tag_map_from_tuple_t<decltype(std::tuple_cat(std::declval<typename std::remove_cvref_t<_TagMaps>::tagged_tuple>()...))>;
+    return result_type(std::tuple_cat(forward_as_tagged_tuple(std::forward<_TagMaps>(tagMaps))...));
 }
 
-template<TagMap... _TagMaps>
-constexpr auto tag_map_cat(_TagMaps const&... tagMaps)
+/**
+* tag_map_cat constructing the result with allocator, see the allocator extended constructors of basic_tag_map.
+*/
+template<typename _Allocator, typename... _TagMaps>
+    requires (TagMap<std::remove_cvref_t<_TagMaps>> && ...)
+constexpr auto tag_map_cat(std::allocator_arg_t,
+                           _Allocator const& allocator,
+                           _TagMaps&&... tagMaps)
 {
-    return make_tag_map(std::tuple_cat(tagMaps.taggedValues...));
+    using result_type = tag_map_from_tuple_t<decltype(std::tuple_cat(std::declval<typename std::remove_cvref_t<_TagMaps>::tagged_tuple>()...))>;
+    return result_type(std::allocator_arg, allocator, std::tuple_cat(forward_as_tagged_tuple(std::forward<_TagMaps>(tagMaps))...));
 }
 
 template<TagMap _TagMap, char_tag... _Tags>
-struct cut_tag_map : std::type_identity<tag_map<typename _TagMap::template get_tagged_value_type_t<_Tags>...>>
+struct cut_tag_map : std::type_identity<typename _TagMap::template rebind_t<typename _TagMap::template get_tagged_value_type_t<_Tags>...>>
 {};
 
 template<TagMap _TagMap, char_tag... _Tags>
 using cut_tag_map_t = typename cut_tag_map<_TagMap, _Tags...>::type;
 
-template<char_tag... _Tags, TagMap _TagMap>
+/**
+* Tag map of copies of the values of the given tags, moved instead if tagMap is an rvalue.
+*/
+template<char_tag... _Tags, typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
 constexpr auto tag_map_cut(_TagMap&& tagMap)
 {
-    return cut_tag_map_t<_TagMap, _Tags...>(std::move(tagMap).template get<_Tags...>());
+    return cut_tag_map_t<std::remove_cvref_t<_TagMap>, _Tags...>(std::forward<_TagMap>(tagMap).template get<_Tags...>());
 }
 
-template<char_tag... _Tags, TagMap _TagMap>
-constexpr auto tag_map_cut(_TagMap const& tagMap)
+/**
+* tag_map_cut constructing the result with allocator, see the allocator extended constructors of basic_tag_map.
+*/
+template<char_tag... _Tags, typename _Allocator, typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+constexpr auto tag_map_cut(std::allocator_arg_t,
+                           _Allocator const& allocator,
+                           _TagMap&& tagMap)
 {
-    return cut_tag_map_t<_TagMap, _Tags...>(tagMap.template get<_Tags...>());
+    return cut_tag_map_t<std::remove_cvref_t<_TagMap>, _Tags...>(std::allocator_arg, allocator, std::forward<_TagMap>(tagMap).template get<_Tags...>());
+}
+
+/**
+* Tag map whose values are all lvalue references, e.g. the result of tie_tag_map or tag_map_view.
+*/
+template<typename>
+struct is_tag_map_view : std::false_type
+{};
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct is_tag_map_view<basic_tag_map<_Layout, _TaggedValues...>>
+    : std::bool_constant<(std::is_lvalue_reference_v<typename _TaggedValues::value_type> && ...)>
+{};
+
+template<typename _Type>
+constexpr bool is_tag_map_view_v = is_tag_map_view<_Type>::value;
+
+/**
+* Tag map of references to the values of some tags of _TagMap, all of them if no tags are given.
+* A const _TagMap yields const references, references of views are taken over, so views of views collapse.
+*/
+template<typename _TagMap, char_tag... _Tags>
+    requires TagMap<std::remove_const_t<_TagMap>>
+struct view_tag_map : std::type_identity<tag_map<tagged_value<_Tags, decltype(std::declval<_TagMap&>().template get<_Tags>())>...>>
+{};
+
+template<typename _TagMap>
+    requires TagMap<std::remove_const_t<_TagMap>>
+struct view_tag_map<_TagMap> : decltype([]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                                        {
+                                            return view_tag_map<_TagMap, std::tuple_element_t<_Indices, typename std::remove_const_t<_TagMap>::tagged_tuple>::tag...>();
+                                        }(std::make_index_sequence<std::tuple_size_v<typename std::remove_const_t<_TagMap>::tagged_tuple>>()))
+{};
+
+template<typename _TagMap, char_tag... _Tags>
+using view_tag_map_t = typename view_tag_map<_TagMap, _Tags...>::type;
+
+/**
+* Non-owning alternative to tag_map_cut, nothing is copied.
+* Temporaries can only be viewed if they are views themselves.
+*/
+template<char_tag... _Tags, typename _TagMap>
+    requires TagMap<std::remove_cvref_t<_TagMap>> && (std::is_lvalue_reference_v<_TagMap> || is_tag_map_view_v<std::remove_cvref_t<_TagMap>>)
+constexpr auto tag_map_view(_TagMap&& tagMap)
+{
+    using view_type = view_tag_map_t<std::remove_reference_t<_TagMap>, _Tags...>;
+    if constexpr (sizeof...(_Tags) == 0)
+        return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            return view_type(tagMap.template get<_Indices>().value...);
+        }(std::make_index_sequence<std::tuple_size_v<view_type>>());
+    else
+        return view_type(tagMap.template get<_Tags>()...);
+}
+
+/**
+* Tag map with the same tags as _TagMap owning copies of its values.
+*/
+template<TagMap _TagMap>
+struct decay_tag_map;
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct decay_tag_map<basic_tag_map<_Layout, _TaggedValues...>>
+    : std::type_identity<basic_tag_map<_Layout, tagged_value<_TaggedValues::tag, std::remove_cvref_t<typename _TaggedValues::value_type>>...>>
+{};
+
+template<TagMap _TagMap>
+using decay_tag_map_t = typename decay_tag_map<_TagMap>::type;
+
+/**
+* Copies the values a view refers to into an owning tag map.
+*/
+template<TagMap _TagMap>
+constexpr auto tag_map_copy(_TagMap const& tagMap)
+{
+    return decay_tag_map_t<_TagMap>(tagMap);
 }
 }
 
@@ -590,3 +1004,10 @@ struct std::tuple_size<_TagMap> : std::tuple_size<typename _TagMap::tagged_tuple
 template<size_t _Index, ctmap::TagMap _TagMap>
 struct std::tuple_element<_Index, _TagMap> : std::tuple_element<_Index, typename _TagMap::tagged_tuple>
 {};
+
+/**
+* Tag maps accept allocators like std::tuple, passing them on to the values that use them.
+*/
+template<typename _Layout, ctmap::TaggedValue... _TaggedValues, typename _Allocator>
+struct std::uses_allocator<ctmap::basic_tag_map<_Layout, _TaggedValues...>, _Allocator> : std::true_type
+{};
@@ -0,0 +1,476 @@
+#pragma once
+#include "ctmap.h"
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+/**
+* Column oriented container of tag maps.
+* Every tag is stored in its own contiguous column, rows are accessed through tag maps of references.
+*/
+template<TaggedValue... _TaggedValues>
+class tag_map_vector
+{
+    static_assert(sizeof...(_TaggedValues) > 0, "tag_map_vector needs at least one tag");
+    static_assert(!(std::is_reference_v<typename _TaggedValues::value_type> || ...), "tag_map_vector cannot store references");
+    static_assert(!(is_computed_value_v<typename _TaggedValues::value_type> || ...), "tag_map_vector cannot store computed values, rows of references would neither compute nor invalidate them");
+
+    /**
+    * Minimal contiguous storage for a single column.
+    * Unlike std::vector, it can hand out a std::span<bool> for bool columns.
+    */
+    template<typename _ValueType>
+    class column_buffer
+    {
+        using allocator_type = std::allocator<_ValueType>;
+        using allocator_traits = std::allocator_traits<allocator_type>;
+
+    public:
+
+        constexpr column_buffer() noexcept = default;
+
+        // delegating makes this a complete object before copying, so the destructor cleans up if a copy throws
+        constexpr column_buffer(column_buffer const& other)
+            : column_buffer()
+        {
+            reserve(other.count);
+            for (auto index = 0uz; index < other.count; ++index)
+                emplace_back(other.values[index]);
+        }
+
+        constexpr column_buffer(column_buffer&& other) noexcept
+            : values(std::exchange(other.values, nullptr))
+            , count(std::exchange(other.count, 0))
+            , reserved(std::exchange(other.reserved, 0))
+        {}
+
+        constexpr column_buffer& operator=(column_buffer other) noexcept
+        {
+            std::swap(values, other.values);
+            std::swap(count, other.count);
+            std::swap(reserved, other.reserved);
+            return *this;
+        }
+
+        constexpr ~column_buffer()
+        {
+            clear();
+            if (values)
+                allocator_traits::deallocate(allocator, values, reserved);
+        }
+
+        constexpr _ValueType* data() noexcept
+        {
+            return values;
+        }
+
+        constexpr _ValueType const* data() const noexcept
+        {
+            return values;
+        }
+
+        constexpr size_t size() const noexcept
+        {
+            return count;
+        }
+
+        constexpr size_t capacity() const noexcept
+        {
+            return reserved;
+        }
+
+        constexpr void reserve(size_t newCapacity)
+        {
+            if (newCapacity <= reserved)
+                return;
+            auto* newValues = allocator_traits::allocate(allocator, newCapacity);
+            auto index = 0uz;
+            try
+            {
+                for (; index < count; ++index)
+                    allocator_traits::construct(allocator, newValues + index, std::move_if_noexcept(values[index]));
+            }
+            catch (...)
+            {
+                std::destroy_n(newValues, index);
+                allocator_traits::deallocate(allocator, newValues, newCapacity);
+                throw;
+            }
+            std::destroy_n(values, count);
+            if (values)
+                allocator_traits::deallocate(allocator, values, reserved);
+            values = newValues;
+            reserved = newCapacity;
+        }
+
+        template<typename... _Args>
+        constexpr _ValueType& emplace_back(_Args&&... args)
+        {
+            if (count == reserved)
+                reserve(reserved ? 2 * reserved : 1);
+            allocator_traits::construct(allocator, values + count, std::forward<_Args>(args)...);
+            return values[count++];
+        }
+
+        constexpr void pop_back() noexcept
+        {
+            std::destroy_at(values + --count);
+        }
+
+        constexpr void clear() noexcept
+        {
+            std::destroy_n(values, count);
+            count = 0;
+        }
+
+    private:
+
+        [[no_unique_address]] allocator_type allocator;
+        _ValueType* values = nullptr;
+        size_t count = 0;
+        size_t reserved = 0;
+    };
+
+public:
+
+    using value_type = tag_map<_TaggedValues...>;
+    using reference = tag_map<tagged_value<_TaggedValues::tag, typename _TaggedValues::value_type&>...>;
+    using const_reference = tag_map<tagged_value<_TaggedValues::tag, typename _TaggedValues::value_type const&>...>;
+
+private:
+
+    template<bool _Const>
+    class basic_iterator
+    {
+        using container_type = std::conditional_t<_Const, tag_map_vector const, tag_map_vector>;
+
+    public:
+
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::conditional_t<_Const, const_reference, tag_map_vector::reference>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<_Const, const_reference, tag_map_vector::reference>;
+
+        constexpr basic_iterator() noexcept = default;
+
+        constexpr basic_iterator(container_type* container, size_t index) noexcept
+            : container(container)
+            , index(index)
+        {}
+
+        constexpr operator basic_iterator<true>() const noexcept
+            requires (!_Const)
+        {
+            return basic_iterator<true>(container, index);
+        }
+
+        constexpr reference operator*() const
+        {
+            return (*container)[index];
+        }
+
+        constexpr reference operator[](difference_type offset) const
+        {
+            return (*container)[index + offset];
+        }
+
+        constexpr basic_iterator& operator++() noexcept
+        {
+            ++index;
+            return *this;
+        }
+
+        constexpr basic_iterator operator++(int) noexcept
+        {
+            auto copy = *this;
+            ++index;
+            return copy;
+        }
+
+        constexpr basic_iterator& operator--() noexcept
+        {
+            --index;
+            return *this;
+        }
+
+        constexpr basic_iterator operator--(int) noexcept
+        {
+            auto copy = *this;
+            --index;
+            return copy;
+        }
+
+        constexpr basic_iterator& operator+=(difference_type offset) noexcept
+        {
+            index += offset;
+            return *this;
+        }
+
+        constexpr basic_iterator& operator-=(difference_type offset) noexcept
+        {
+            index -= offset;
+            return *this;
+        }
+
+        friend constexpr basic_iterator operator+(basic_iterator it, difference_type offset) noexcept
+        {
+            return it += offset;
+        }
+
+        friend constexpr basic_iterator operator+(difference_type offset, basic_iterator it) noexcept
+        {
+            return it += offset;
+        }
+
+        friend constexpr basic_iterator operator-(basic_iterator it, difference_type offset) noexcept
+        {
+            return it -= offset;
+        }
+
+        friend constexpr difference_type operator-(basic_iterator const& lhs, basic_iterator const& rhs) noexcept
+        {
+            return static_cast<difference_type>(lhs.index) - static_cast<difference_type>(rhs.index);
+        }
+
+        friend constexpr bool operator==(basic_iterator const& lhs, basic_iterator const& rhs) noexcept
+        {
+            return lhs.index == rhs.index;
+        }
+
+        friend constexpr auto operator<=>(basic_iterator const& lhs, basic_iterator const& rhs) noexcept
+        {
+            return lhs.index <=> rhs.index;
+        }
+
+    private:
+
+        container_type* container = nullptr;
+        size_t index = 0;
+    };
+
+public:
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    constexpr tag_map_vector() noexcept = default;
+
+    template<char_tag _Tag>
+    constexpr static bool is_tag_valid()
+    {
+        return value_type::template is_tag_valid<_Tag>();
+    }
+
+    template<char_tag _Tag>
+    constexpr static size_t tag_index()
+    {
+        return value_type::template tag_index<_Tag>();
+    }
+
+    template<char_tag _Tag>
+    using get_tag_value_type_t = typename value_type::template get_tag_value_type_t<_Tag>;
+
+    constexpr size_t size() const noexcept
+    {
+        return std::get<0>(columns).size();
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    constexpr size_t capacity() const noexcept
+    {
+        return std::get<0>(columns).capacity();
+    }
+
+    constexpr void reserve(size_t newCapacity)
+    {
+        std::apply([&](auto&... column)
+                   {
+                       (column.reserve(newCapacity), ...);
+                   },
+                   columns);
+    }
+
+    constexpr void clear() noexcept
+    {
+        std::apply([](auto&... column)
+                   {
+                       (column.clear(), ...);
+                   },
+                   columns);
+    }
+
+    template<char_tag _Tag>
+    constexpr std::span<get_tag_value_type_t<_Tag>> column() noexcept
+    {
+        auto& column = std::get<tag_index<_Tag>()>(columns);
+        return { column.data(), column.size() };
+    }
+
+    template<char_tag _Tag>
+    constexpr std::span<get_tag_value_type_t<_Tag> const> column() const noexcept
+    {
+        auto const& column = std::get<tag_index<_Tag>()>(columns);
+        return { column.data(), column.size() };
+    }
+
+    constexpr reference operator[](size_t index) noexcept
+    {
+        return std::apply([index](auto&... column)
+                          {
+                              return reference(column.data()[index]...);
+                          },
+                          columns);
+    }
+
+    constexpr const_reference operator[](size_t index) const noexcept
+    {
+        return std::apply([index](auto const&... column)
+                          {
+                              return const_reference(column.data()[index]...);
+                          },
+                          columns);
+    }
+
+    constexpr reference front() noexcept
+    {
+        return (*this)[0];
+    }
+
+    constexpr const_reference front() const noexcept
+    {
+        return (*this)[0];
+    }
+
+    constexpr reference back() noexcept
+    {
+        return (*this)[size() - 1];
+    }
+
+    constexpr const_reference back() const noexcept
+    {
+        return (*this)[size() - 1];
+    }
+
+    constexpr iterator begin() noexcept
+    {
+        return iterator(this, 0);
+    }
+
+    constexpr const_iterator begin() const noexcept
+    {
+        return const_iterator(this, 0);
+    }
+
+    constexpr const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    constexpr iterator end() noexcept
+    {
+        return iterator(this, size());
+    }
+
+    constexpr const_iterator end() const noexcept
+    {
+        return const_iterator(this, size());
+    }
+
+    constexpr const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    template<TagMap _TagMap>
+        requires std::constructible_from<value_type, _TagMap const&>
+    constexpr void push_back(_TagMap const& tagMap)
+    {
+        apply([this](auto const&... taggedValues)
+              {
+                  emplace_back(taggedValues.value...);
+              },
+              tagMap);
+    }
+
+    template<TagMap _TagMap>
+        requires std::constructible_from<value_type, _TagMap&&>
+    constexpr void push_back(_TagMap&& tagMap)
+    {
+        apply([this](auto&&... taggedValues)
+              {
+                  emplace_back(std::forward<decltype(taggedValues.value)>(taggedValues.value)...);
+              },
+              std::move(tagMap));
+    }
+
+    /**
+    * Appends a row by constructing every column in place from the value at the same position.
+    */
+    template<typename... _ValueTypes>
+        requires (sizeof...(_ValueTypes) == sizeof...(_TaggedValues)) && (std::constructible_from<typename _TaggedValues::value_type, _ValueTypes> && ...)
+    constexpr reference emplace_back(_ValueTypes&&... values)
+    {
+        if (size() == capacity())
+            reserve(capacity() ? 2 * capacity() : 1);
+        emplace_back_impl<0>(std::forward<_ValueTypes>(values)...);
+        return back();
+    }
+
+    constexpr void pop_back() noexcept
+    {
+        std::apply([](auto&... column)
+                   {
+                       (column.pop_back(), ...);
+                   },
+                   columns);
+    }
+
+private:
+
+    template<size_t _Index, typename _ValueType, typename... _ValueTypes>
+    constexpr void emplace_back_impl(_ValueType&& value, _ValueTypes&&... values)
+    {
+        std::get<_Index>(columns).emplace_back(std::forward<_ValueType>(value));
+        if constexpr (sizeof...(_ValueTypes) > 0)
+        {
+            try
+            {
+                emplace_back_impl<_Index + 1>(std::forward<_ValueTypes>(values)...);
+            }
+            catch (...)
+            {
+                std::get<_Index>(columns).pop_back();
+                throw;
+            }
+        }
+    }
+
+    std::tuple<column_buffer<typename _TaggedValues::value_type>...> columns;
+};
+
+template<typename>
+struct tag_map_vector_from_tag_map;
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct tag_map_vector_from_tag_map<basic_tag_map<_Layout, _TaggedValues...>> : std::type_identity<tag_map_vector<_TaggedValues...>>
+{};
+
+template<TagMap _TagMap>
+using tag_map_vector_from_tag_map_t = typename tag_map_vector_from_tag_map<_TagMap>::type;
+}
@@ -2,6 +2,7 @@
 #include "char_tag.h"
 
 #include <concepts>
+#include <memory>
 #include <utility>
 
 
@@ -16,6 +17,12 @@ struct tagged_value
     constexpr static auto tag = _Tag;
     using value_type = _ValueType;
 
+    // not explicit, so tuples of tagged values can be default constructed with an allocator
+    constexpr tagged_value()
+        requires std::default_initializable<value_type>
+        : value()
+    {}
+
     template<typename ..._Args>
         requires std::constructible_from<value_type, _Args...>
     constexpr explicit tagged_value(_Args&&... args)
@@ -34,7 +41,49 @@ struct tagged_value
         : value(taggedValue.value)
     {}
 
-    value_type value;
+    /**
+    * Uses-allocator construction: allocator aware values are constructed with allocator, others ignore it.
+    */
+    template<typename _Allocator, typename... _Args>
+        requires std::uses_allocator_v<value_type, _Allocator> && std::constructible_from<value_type, std::allocator_arg_t, _Allocator const&, _Args...>
+    constexpr explicit tagged_value(std::allocator_arg_t,
+                                    _Allocator const& allocator,
+                                    _Args&&... args)
+        : value(std::allocator_arg, allocator, std::forward<_Args>(args)...)
+    {}
+
+    template<typename _Allocator, typename... _Args>
+        requires std::uses_allocator_v<value_type, _Allocator> && (!std::constructible_from<value_type, std::allocator_arg_t, _Allocator const&, _Args...>)
+                 && std::constructible_from<value_type, _Args..., _Allocator const&>
+    constexpr explicit tagged_value(std::allocator_arg_t,
+                                    _Allocator const& allocator,
+                                    _Args&&... args)
+        : value(std::forward<_Args>(args)..., allocator)
+    {}
+
+    template<typename _Allocator, typename... _Args>
+        requires (!std::uses_allocator_v<value_type, _Allocator>) && std::constructible_from<value_type, _Args...>
+    constexpr explicit tagged_value(std::allocator_arg_t,
+                                    _Allocator const&,
+                                    _Args&&... args)
+        : value(std::forward<_Args>(args)...)
+    {}
+
+    template<typename _Allocator, typename _OtherValueType>
+    constexpr explicit tagged_value(std::allocator_arg_t,
+                                    _Allocator const& allocator,
+                                    tagged_value<_Tag, _OtherValueType>&& taggedValue)
+        : tagged_value(std::allocator_arg, allocator, std::forward<_OtherValueType&&>(taggedValue.value))
+    {}
+
+    template<typename _Allocator, typename _OtherValueType>
+    constexpr explicit tagged_value(std::allocator_arg_t,
+                                    _Allocator const& allocator,
+                                    tagged_value<_Tag, _OtherValueType> const& taggedValue)
+        : tagged_value(std::allocator_arg, allocator, taggedValue.value)
+    {}
+
+    [[no_unique_address]] value_type value;
 };
 
 template<typename>
@@ -64,6 +113,12 @@ constexpr auto make_tagged(std::reference_wrapper<_ValueType>&& value)
     return tagged_value<_Tag, _ValueType&>(value.get());
 }
 
+/**
+* Type make_tagged returns for a value of type _ValueType, so tagged values can be constructed in place instead.
+*/
+template<char_tag _Tag, typename _ValueType>
+using make_tagged_t = decltype(make_tagged<_Tag>(std::declval<_ValueType>()));
+
 template<char_tag _Tag, typename _ValueType, typename... _ValueTypes>
 constexpr auto make_tagged(_ValueTypes&&... values)
 {
@@ -96,3 +151,7 @@ constexpr auto operator<=>(tagged_value<_Tag, _LhsValueType> const& lhs,
     return lhs.value <=> rhs.value;
 }
 }
+
+template<ctmap::char_tag _Tag, typename _ValueType, typename _Allocator>
+struct std::uses_allocator<ctmap::tagged_value<_Tag, _ValueType>, _Allocator> : std::uses_allocator<_ValueType, _Allocator>
+{};
@@ -0,0 +1,151 @@
+#pragma once
+#include "ctmap.h"
+#include "sparse_tag_map.h"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+
+namespace ctmap
+{
+/**
+* Tag map remembering which tagged values were accessed mutably since the dirty bits were last cleared.
+* Mutable get and apply set the bits of the tags they hand out, which is a single or into a bitmask stored next to the values.
+* Const access leaves the bits alone, so code only reading values should go through a const reference or values().
+*/
+template<TaggedValue... _TaggedValues>
+class tracked_tag_map
+{
+public:
+
+    using values_type = tag_map<_TaggedValues...>;
+
+    template<char_tag _Tag>
+    using get_tagged_value_type_t = typename values_type::template get_tagged_value_type_t<_Tag>;
+    template<char_tag _Tag>
+    using get_tag_value_type_t = typename values_type::template get_tag_value_type_t<_Tag>;
+
+    /**
+    * Constructs the values like tag_map does, with no tag dirty.
+    */
+    template<typename... _Args>
+        requires std::constructible_from<values_type, _Args...>
+    constexpr explicit tracked_tag_map(_Args&&... args)
+        : dirty()
+        , taggedValues(std::forward<_Args>(args)...)
+    {}
+
+    template<char_tag _Tag>
+    constexpr static bool is_tag_valid()
+    {
+        return values_type::template is_tag_valid<_Tag>();
+    }
+
+    template<char_tag _Tag>
+    constexpr static size_t tag_index()
+    {
+        return values_type::template tag_index<_Tag>();
+    }
+
+    constexpr values_type const& values() const noexcept
+    {
+        return taggedValues;
+    }
+
+    template<char_tag _Tag>
+    constexpr auto& get() noexcept
+    {
+        constexpr auto index = tag_index<_Tag>();
+        dirty.set(index);
+        return taggedValues.template get<_Tag>();
+    }
+
+    template<char_tag _Tag>
+    constexpr auto const& get() const noexcept
+    {
+        return taggedValues.template get<_Tag>();
+    }
+
+    template<size_t _Index>
+    constexpr auto& get() noexcept
+    {
+        dirty.set(_Index);
+        return taggedValues.template get<_Index>();
+    }
+
+    template<size_t _Index>
+    constexpr auto const& get() const noexcept
+    {
+        return taggedValues.template get<_Index>();
+    }
+
+    template<all_tags_t, typename _Function>
+    constexpr auto apply(_Function&& function)
+    {
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            (dirty.set(_Indices), ...);
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+        return taggedValues.template apply<all_tags>(std::forward<_Function>(function));
+    }
+
+    template<all_tags_t, typename _Function>
+    constexpr auto apply(_Function&& function) const
+    {
+        return taggedValues.template apply<all_tags>(std::forward<_Function>(function));
+    }
+
+    template<char_tag... _Tags, typename _Function>
+    constexpr auto apply(_Function&& function)
+    {
+        constexpr std::array<size_t, sizeof...(_Tags)> indices = { tag_index<_Tags>()... };
+        for (auto index : indices)
+            dirty.set(index);
+        return taggedValues.template apply<_Tags...>(std::forward<_Function>(function));
+    }
+
+    template<char_tag... _Tags, typename _Function>
+    constexpr auto apply(_Function&& function) const
+    {
+        return taggedValues.template apply<_Tags...>(std::forward<_Function>(function));
+    }
+
+    template<char_tag _Tag>
+    constexpr bool is_dirty() const noexcept
+    {
+        constexpr auto index = tag_index<_Tag>();
+        return dirty.test(index);
+    }
+
+    constexpr size_t dirty_count() const noexcept
+    {
+        return dirty.count();
+    }
+
+    /**
+    * Calls function with every dirty tagged value, in declared order.
+    */
+    template<typename _Function>
+    constexpr void for_each_dirty(_Function&& function) const
+    {
+        [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+        {
+            ((dirty.test(_Indices) ? void(function(taggedValues.template get<_Indices>())) : void()), ...);
+        }(std::make_index_sequence<sizeof...(_TaggedValues)>());
+    }
+
+    constexpr void clear_dirty() noexcept
+    {
+        dirty = presence_mask<sizeof...(_TaggedValues)>();
+    }
+
+private:
+
+    // in front of the values, so it shares a cache line with the first of them
+    presence_mask<sizeof...(_TaggedValues)> dirty;
+    values_type taggedValues;
+};
+}
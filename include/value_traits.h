@@ -0,0 +1,18 @@
+#pragma once
+#include <optional>
+#include <type_traits>
+
+
+namespace ctmap
+{
+template<typename>
+struct is_optional : std::false_type
+{};
+
+template<typename _ValueType>
+struct is_optional<std::optional<_ValueType>> : std::true_type
+{};
+
+template<typename _Type>
+constexpr bool is_optional_v = is_optional<_Type>::value;
+}
@@ -0,0 +1,248 @@
+#pragma once
+#include "ctmap.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace ctmap
+{
+/**
+* Compile time perfect hash over a list of tags for looking up tags only known at runtime.
+* Keys are hashed into buckets, every bucket gets a displacement that moves its keys into free slots
+* (hash and displace), so a lookup is two hashes, two table reads and one string comparison.
+*/
+template<char_tag... _Tags>
+struct tag_hash_table
+{
+    constexpr static std::size_t size = sizeof...(_Tags);
+    constexpr static std::size_t npos = size;
+
+private:
+
+    constexpr static std::size_t bucket_count = std::bit_ceil(std::max(size, 1uz));
+    constexpr static std::size_t slot_count = 2 * bucket_count;
+
+    constexpr static std::array<std::string_view, size> names = { _Tags.view()... };
+
+    constexpr static std::uint64_t mix(std::uint64_t hash) noexcept
+    {
+        hash ^= hash >> 30;
+        hash *= 0xbf58476d1ce4e5b9ull;
+        hash ^= hash >> 27;
+        hash *= 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+
+    constexpr static std::uint64_t hash(std::string_view name) noexcept
+    {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (auto character : name)
+            hash = (hash ^ static_cast<unsigned char>(character)) * 0x100000001b3ull;
+        return mix(hash);
+    }
+
+    constexpr static std::size_t slot(std::uint64_t hash, std::uint32_t displacement) noexcept
+    {
+        return mix(hash + displacement) & (slot_count - 1);
+    }
+
+    struct table
+    {
+        std::array<std::uint32_t, bucket_count> displacements{};
+        std::array<std::size_t, slot_count> slots{};
+    };
+
+    constexpr static table build()
+    {
+        table result;
+        result.slots.fill(npos);
+
+        std::array<std::uint64_t, size> hashes{};
+        std::array<std::size_t, bucket_count> bucketSizes{};
+        std::array<std::size_t, size> order{};
+        for (auto index = 0uz; index < size; ++index)
+        {
+            hashes[index] = hash(names[index]);
+            ++bucketSizes[hashes[index] & (bucket_count - 1)];
+            order[index] = index;
+        }
+        auto const bucket = [&](std::size_t index)
+        {
+            return hashes[index] & (bucket_count - 1);
+        };
+        // place the largest buckets first while most slots are still free
+        std::ranges::sort(order, [&](std::size_t lhs, std::size_t rhs)
+                          {
+                              if (bucketSizes[bucket(lhs)] != bucketSizes[bucket(rhs)])
+                                  return bucketSizes[bucket(lhs)] > bucketSizes[bucket(rhs)];
+                              return bucket(lhs) < bucket(rhs);
+                          });
+
+        for (auto first = 0uz; first < size;)
+        {
+            auto last = first;
+            while (last < size && bucket(order[last]) == bucket(order[first]))
+                ++last;
+
+            for (std::uint32_t displacement = 0;; ++displacement)
+            {
+                auto placed = first;
+                for (; placed < last; ++placed)
+                {
+                    auto& target = result.slots[slot(hashes[order[placed]], displacement)];
+                    if (target != npos)
+                        break;
+                    target = order[placed];
+                }
+                if (placed == last)
+                {
+                    result.displacements[bucket(order[first])] = displacement;
+                    break;
+                }
+                for (auto index = first; index < placed; ++index)
+                    result.slots[slot(hashes[order[index]], displacement)] = npos;
+            }
+            first = last;
+        }
+        return result;
+    }
+
+    constexpr static table lookup = build();
+
+public:
+
+    /**
+    * Position of the tag in the list, or npos if it is not part of the list.
+    */
+    constexpr static std::size_t find(std::string_view name) noexcept
+    {
+        if constexpr (size == 0)
+            return npos;
+        else
+        {
+            auto const nameHash = hash(name);
+            auto const index = lookup.slots[slot(nameHash, lookup.displacements[nameHash & (bucket_count - 1)])];
+            if (index == npos || names[index] != name)
+                return npos;
+            return index;
+        }
+    }
+};
+
+template<TagMap _TagMap>
+struct tag_map_hash_table;
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct tag_map_hash_table<basic_tag_map<_Layout, _TaggedValues...>> : std::type_identity<tag_hash_table<_TaggedValues::tag...>>
+{};
+
+template<TagMap _TagMap>
+using tag_map_hash_table_t = typename tag_map_hash_table<_TagMap>::type;
+
+/**
+* Result of visiting a tag map with a runtime tag.
+* bool for visitors returning void, otherwise an optional holding the visitor's result, empty if the tag is unknown.
+*/
+template<typename _Function, typename _TagMap>
+struct visit_result
+{
+    using result_type = decltype([]<size_t... _Indices>(std::index_sequence<_Indices...>)
+                                 {
+                                     return std::type_identity<std::common_type_t<
+                                         std::invoke_result_t<_Function, decltype(std::declval<_TagMap>().template get<std::remove_cvref_t<_TagMap>::template index_tag<_Indices>()>())>...
+                                     >>();
+                                 }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<_TagMap>>>()))::type;
+
+    using type = std::conditional_t<std::is_void_v<result_type>, bool, std::optional<result_type>>;
+};
+
+template<typename _Function, typename _TagMap>
+using visit_result_t = typename visit_result<_Function, _TagMap>::type;
+
+/**
+* The tags of a tag map in declared order, as views into a single compile time string pool.
+* Every name is followed by a null character in the pool, so data() of each view is also a C string.
+*/
+template<TagMap _TagMap>
+struct tag_name_table;
+
+template<typename _Layout, TaggedValue... _TaggedValues>
+struct tag_name_table<basic_tag_map<_Layout, _TaggedValues...>>
+{
+private:
+
+    constexpr static auto pool = []
+    {
+        std::array<char, ((_TaggedValues::tag.view().size() + 1) + ... + 0)> result{};
+        [[maybe_unused]] auto out = result.begin();
+        ((out = std::ranges::copy(_TaggedValues::tag.view(), out).out, *out++ = '\0'), ...);
+        return result;
+    }();
+
+public:
+
+    constexpr static std::array<std::string_view, sizeof...(_TaggedValues)> names = []
+    {
+        std::array<std::string_view, sizeof...(_TaggedValues)> result{};
+        [[maybe_unused]] auto offset = 0uz;
+        [[maybe_unused]] auto index = 0uz;
+        ((result[index++] = std::string_view(pool.data() + offset, _TaggedValues::tag.view().size()),
+          offset += _TaggedValues::tag.view().size() + 1), ...);
+        return result;
+    }();
+};
+
+template<TagMap _TagMap>
+constexpr auto const& tag_names() noexcept
+{
+    return tag_name_table<_TagMap>::names;
+}
+
+/**
+* Calls function with the value at a runtime index in declared order, computed tags with their result.
+* The index is compared against every position in one flat fold, which compilers turn into a single jump table
+* with the calls inlined into it, unlike an array of function pointers, whose calls stay opaque.
+* The result is empty (false for visitors returning void) if the index is out of range.
+*/
+template<typename _TagMap, typename _Function>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+constexpr auto visit_index(_TagMap&& tagMap,
+                           size_t index,
+                           _Function&& function)
+{
+    using tag_map_type = std::remove_cvref_t<_TagMap>;
+    using result_type = visit_result_t<_Function, _TagMap&&>;
+    return [&]<size_t... _Indices>(std::index_sequence<_Indices...>)
+    {
+        result_type result{};
+        if constexpr (std::is_void_v<typename visit_result<_Function, _TagMap&&>::result_type>)
+            ((index == _Indices && (std::invoke(std::forward<_Function>(function), std::forward<_TagMap>(tagMap).template get<tag_map_type::template index_tag<_Indices>()>()), result = true)) || ...);
+        else
+            ((index == _Indices && (result.emplace(std::invoke(std::forward<_Function>(function), std::forward<_TagMap>(tagMap).template get<tag_map_type::template index_tag<_Indices>()>())), true)) || ...);
+        return result;
+    }(std::make_index_sequence<std::tuple_size_v<std::remove_cvref_t<_TagMap>>>());
+}
+
+/**
+* Calls function with the value of the tag named by a runtime string.
+* Dispatch is a perfect hash lookup followed by visit_index, no allocation and no string comparison chain.
+*/
+template<typename _TagMap, typename _Function>
+    requires TagMap<std::remove_cvref_t<_TagMap>>
+constexpr auto visit(_TagMap&& tagMap,
+                     std::string_view tag,
+                     _Function&& function)
+{
+    using tag_map_type = std::remove_cvref_t<_TagMap>;
+    return visit_index(std::forward<_TagMap>(tagMap), tag_map_hash_table_t<tag_map_type>::find(tag), std::forward<_Function>(function));
+}
+}